@@ -0,0 +1,48 @@
+#ifndef __CACHED_LAYER_H__
+#define __CACHED_LAYER_H__
+
+#include <cstdio>
+#include <functional>
+
+#include "glad/gl.h"
+#include "glm/glm.hpp"
+
+#include "sprite.h"
+#include "texture.h"
+#include "camera.h"
+#include "gl_state.h"
+
+// Keeps a layer of the frame which rarely changes drawn into a texture the size of the screen. The layer is only drawn
+// again after it has been invalidated, and in between it costs a single full-screen quad drawn through the batch.
+// A layer which changes every frame would only pay for that quad on top of drawing itself, so a layer invalidated
+// since it was last rendered is drawn directly, and only goes back into its texture once it stays the same for a frame.
+// The texture holds premultiplied alpha (see GLState::blend), so the layer blends exactly like drawing it directly would.
+class CachedLayer {
+  public:
+    // The size of the texture is the size of the viewport the layer is drawn into
+    CachedLayer(OrthoCamera *camera, unsigned int width, unsigned int height);
+    ~CachedLayer();
+
+    // Resize the texture, which invalidates the layer
+    void resize(unsigned int width, unsigned int height);
+
+    // Draw the layer again the next time it is rendered
+    void invalidate() { this->dirty = this->changed = true; }
+
+    // Draw the layer through the given function, either straight onto the screen or into its texture (if needed)
+    // followed by the texture. Anything queued in the batch is flushed first.
+    void render(SpriteBatch *batch, const std::function<void()> &draw);
+
+    // The number of times the layer was drawn into its texture
+    unsigned long redraws;
+
+  private:
+    OrthoCamera *camera;
+    unsigned int fbo;
+    Texture texture;
+
+    // Whether the texture is out of date, and whether the layer changed since it was last rendered
+    bool dirty, changed;
+};
+
+#endif
@@ -26,6 +26,17 @@ class Camera {
   // The closest and the farthest plane the camera will render
   float near, far;
 
+  // Make this the camera every shader reads its matrices from. The matrices live in a uniform buffer on the
+  // camera's binding point, which is filled again whenever the camera is scaled or resized.
+  void bind();
+
+ protected:
+  // The uniform buffer holding the projection and the view matrix, created the first time the camera is bound
+  unsigned int ubo = 0;
+
+  // Copy the matrices into the uniform buffer, if the camera has one
+  void upload();
+
 // protected:
 //   // The closest and the farthest plane the camera will render
 //   float near, far;
@@ -0,0 +1,44 @@
+#ifndef __DEBUG_DRAW_H__
+#define __DEBUG_DRAW_H__
+
+#include <string>
+#include <vector>
+#include <cmath>
+
+#include "glad/gl.h"
+#include "glm/glm.hpp"
+
+#include "sprite.h"
+#include "stream_buffer.h"
+#include "physics.h"
+#include "font.h"
+#include "resource_manager.h"
+
+// This namespace draws debug shapes in world space, immediate-mode style: anything can add shapes at any point of a
+// frame, and they are all drawn at once when the frame flushes them. Every shape is turned into the quads the sprite
+// batch draws, so the whole frame's shapes are streamed through StreamBuffer at once, and drawn with a single draw call.
+// Labels are drawn as text afterwards, one draw call each.
+namespace DebugDraw {
+  // The number of quads drawn per draw call at most, so each chunk of them fits into a region of the stream buffer
+  const unsigned int CHUNK = 4096;
+
+  // A line of the given width (in world units)
+  void line(glm::vec2 from, glm::vec2 to, glm::vec4 colour, float width = 1.0f);
+
+  // The outline of a bounding box, drawn on the inside of the box
+  void box(BoundingBox box, glm::vec4 colour, float width = 1.0f);
+
+  // A filled rectangle, given by its top-left corner and size
+  void rect(glm::vec2 position, glm::vec2 size, glm::vec4 colour);
+
+  // A filled square centred on a point
+  void point(glm::vec2 position, glm::vec4 colour, float size = 6.0f);
+
+  // A line of text with the start of its baseline at the given position
+  void label(const std::string &text, glm::vec2 position, glm::vec4 colour = glm::vec4(1.0f), float scale = 0.3f);
+
+  // Draw every shape and label added since the last flush, and forget them
+  void flush();
+}
+
+#endif
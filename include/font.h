@@ -7,13 +7,22 @@
 #include <cstdio>
 #include <string>
 #include <map>
+#include <list>
+#include <unordered_map>
+#include <vector>
+#include <algorithm>
 #include <stdexcept>
+#include <string_view>
+#include <functional>
+#include <cstdint>
 
 #include "glm/glm.hpp"
 
 #include "shader.h"
 #include "utils.h"
 #include "camera.h"
+#include "render_stats.h"
+#include "stream_buffer.h"
 
 #define TEXT_TOP_LEFT 0
 #define TEXT_TOP_CENTER 1
@@ -24,10 +33,12 @@
 #define TEXT_BOTTOM_LEFT 6
 #define TEXT_BOTTOM_CENTER 7
 #define TEXT_BOTTOM_RIGHT 8
+#define TEXT_BASELINE 9      // Not aligned to the screen, the position is the start of the baseline
 
 // Struct storing character information
 typedef struct Character {
-  unsigned int texture_id;  // The id of the glyph
+  unsigned int texture_id;  // The id of the atlas holding the glyph, shared by every glyph of the font
+  glm::vec4 uv;             // The region of the atlas holding the glyph, as (x, y, width, height) in texture coordinates
   glm::ivec2 size;          // The physical size of the glyph
   glm::ivec2 bearing;       // Offset from baseline to top-left of the glyph
   unsigned int advance;     // Offset to advance to the next glyph
@@ -37,13 +48,25 @@ extern std::map<std::string, std::map<char, Character>> CharacterLookup;
 extern Shader TextShader; 
 extern OrthoCamera *TextCamera;
 
-// Namespace to generally deal with text rendering
+// Namespace to generally deal with text rendering.
+// Every glyph of a font lives in a single atlas, so a whole string is drawn with one draw call. Strings are laid out
+// once per font and scale, and kept in a least recently used cache, so text that does not change is never laid out again.
+// The quads of a layout are kept on the CPU and streamed (see StreamBuffer) whenever the string is drawn, so laying out
+// and evicting strings never creates or deletes GL objects.
 namespace Text {
+  // The number of layouts the cache holds before it starts evicting them
+  const unsigned int LAYOUT_CACHE = 64;
+
   void render(std::string str, const char *font, Transform transform, short alignment = TEXT_TOP_LEFT, glm::vec4 colour = glm::vec4(1.0f));
 }
 
 // Namespace to deal with font management
 namespace Fonts {
+  // Glyphs are rasterised once at this size, and stored as signed distance fields reaching this far past their
+  // edges (in pixels of the rasterised glyph). The same atlas then draws sharp text at any scale.
+  const unsigned int SDF_SIZE = 48;
+  const int SDF_SPREAD = 6;
+
   void init(FT_Library &ft);
 }
 
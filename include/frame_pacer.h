@@ -0,0 +1,48 @@
+#ifndef __FRAME_PACER_H__
+#define __FRAME_PACER_H__
+
+#include <stdio.h>
+#include <ctime>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+
+#include <GLFW/glfw3.h>
+
+// How buffer swaps are synchronised with the display's refresh
+typedef enum VsyncMode {
+  VSYNC_OFF,
+  VSYNC_ON,
+
+  // Synchronise with the refresh, unless the frame is already late, in which case it tears rather than waiting for
+  // the next refresh. Falls back to VSYNC_ON where the driver cannot do that.
+  VSYNC_ADAPTIVE
+} VsyncMode;
+
+// This namespace paces the main loop, so it does not spin a core rendering frames nobody gets to see. Besides vsync,
+// frames can be capped to a rate of their own, and they are throttled while the window is unfocused or minimised.
+namespace FramePacer {
+  // The vsync mode, the frame rate cap (0 for none), and whether to run as fast as possible (for benchmarks), which
+  // overrides the other two and the throttling. These have to be set before init.
+  extern VsyncMode vsync;
+  extern double fps_cap;
+  extern bool uncapped;
+
+  // The frame rates the loop is throttled to while the window is unfocused or minimised
+  const double UNFOCUSED_FPS = 30.0;
+  const double MINIMISED_FPS = 5.0;
+
+  // Sleeping is only accurate to a millisecond or so, so the last slice before a frame is due is spun instead
+  const double SPIN_SLICE = 0.002;
+
+  // Report the frame rate and the share of a core the process used, once a second
+  extern bool report;
+
+  // Apply the vsync mode to the current context, which is the game window's
+  void init();
+
+  // Wait until the next frame is due, once the current one has been swapped
+  void wait(GLFWwindow *window);
+}
+
+#endif
@@ -6,10 +6,15 @@
 
 #include <stdio.h>
 #include <map>
+#include <unordered_set>
 #include <stdexcept>
 #include <chrono>
 #include <unistd.h>
 #include <fstream>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <random>
 
 #include "glm/glm.hpp"
 
@@ -22,15 +27,34 @@
 #include "player.h"
 #include "utils.h"
 #include "font.h"
+#include "physics.h"
+#include "triple_buffer.h"
+#include "preview.h"
+#include "render_queue.h"
+#include "cached_layer.h"
+#include "parallax.h"
+#include "frame_pacer.h"
+#include "headless.h"
+
+// The most physics ticks that will be simulated within a single frame
+#define MAX_TICKS_PER_FRAME 5
+
+// How many ticks ahead the path of the player is predicted while a tile is being dragged
+#define PREVIEW_TICKS 300
+
+// How far past the edges of the screen culling looks for sprites in the spatial index. The index is only rebuilt
+// once per tick, so this covers the objects that moved onto the screen since. It has nothing to do with how far a
+// sprite reaches past its collider, as the sprites are indexed by their own bounds.
+#define CULL_MARGIN 64.0f
 
 class Game {
   public:
     // This struct defines how information about the current mouse state is stored within the program
     typedef struct MouseState {
       // General mouse information
-      bool left_button, left_button_down, left_button_up;
-      bool right_button, right_button_down, right_button_up;
-      glm::vec2 position;
+      bool left_button = false, left_button_down = false, left_button_up = false;
+      bool right_button = false, right_button_down = false, right_button_up = false;
+      glm::vec2 position = glm::vec2(0.0f);
       
       // Information relating to selected GameObjects
       GameObject *clicked_object = nullptr;
@@ -42,16 +66,69 @@ class Game {
       bool pressed, down, released;
     };
 
+    // This struct holds everything that a single frame needs to render. It only points into a WorldState, never into
+    // the live world, so a frame can be drawn on one thread while the simulation runs on another.
+    typedef struct RenderView {
+      std::vector<ObjectSnapshot *> objects;
+
+      // The objects the camera sees (see Game::cull), in the same order as the objects
+      std::vector<ObjectSnapshot *> visible;
+      std::vector<ObjectSnapshot *> focused_objects;
+      ObjectSnapshot *clicked_object = nullptr;
+      ObjectSnapshot *player_parent = nullptr;
+      ObjectSnapshot *player = nullptr;
+      glm::vec2 mouse_position = glm::vec2(0.0f);
+      std::vector<glm::vec2> trajectory;
+      unsigned long tile_revision = 0;
+      bool game_over = false, lost = false, immovable_player = false, player_died = false;
+    };
+
+    // This struct holds a snapshot of every active object, and of the rest of the world a frame needs, sorted by id.
+    // Objects are referenced by their id, as pointers into the live world would not be safe to follow.
+    typedef struct WorldState {
+      std::vector<ObjectSnapshot> objects;
+      std::vector<unsigned long> visible;
+      std::vector<unsigned long> focused_objects;
+      long clicked_object = -1;
+      long player_parent = -1;
+      long player = -1;
+      glm::vec2 mouse_position = glm::vec2(0.0f);
+      std::vector<glm::vec2> trajectory;
+      unsigned long tile_revision = 0;
+      bool game_over = false, lost = false, immovable_player = false, player_died = false;
+    };
+
     // Set up state variables
     MouseState Mouse;
     std::map<int, KeyState> Keyboard;
     std::map<std::string, bool> GameState;
     std::map<std::string, std::string> CriticalGameState;
 
+    // The input callbacks write into these, and the simulation picks them up at the start of each update.
+    // Access to them must be guarded by the InputMutex, as the callbacks and the simulation may run on different threads.
+    MouseState PendingMouse;
+    std::map<int, KeyState> PendingKeyboard;
+    std::mutex InputMutex;
+
     // Set up other generic variables
     unsigned int width, height;
     bool fullscreen = false;
 
+    // Run the simulation on its own thread, with the render thread drawing the latest published world state
+    bool threaded = false;
+
+    // The number of walkers in the crowd benchmark. If set, the time spent simulating is reported regularly.
+    unsigned int crowd = 0;
+
+    // Report what the renderer submitted, averaged over every second of frames
+    bool render_stats = false;
+
+    // Outline the collider and mark the origin of every object, tiles included
+    bool debug_draw = false;
+
+    // Draw the backgrounds and the tiles into cached layers, which are only drawn again once they change
+    bool cache_layers = true;
+
     // The constructor function that takes the default width and height as the starting arguments
     Game(unsigned int width, unsigned int height, std::string window_title, bool fullscreen = false);
     ~Game();
@@ -63,10 +140,16 @@ class Game {
     void run();
 
     // This function contains code to render stuff on the screen
-    void render();
+    void render(RenderView view);
+
+    // This function contains code to update variables like input events, etc. The delta is the time since the last update.
+    void update(double delta);
 
-    // This function contains code to update variables like input events, etc.
-    void update();
+    // This function advances the physics simulation by a single fixed tick
+    void step();
+
+    // Draw a stress scene of the given number of sprites, both one at a time and batched, and report what a frame costs
+    void benchmark_sprites(unsigned int count);
 
     // Returns the global state of the variable if it exists, otherwise returns false.
     bool state(std::string);
@@ -74,6 +157,9 @@ class Game {
     // Returns the global state of the critical variable if it exists, otherwise returns false.
     std::string cstate(std::string);
 
+    // Generate a level of random tiles with the given number of walkers scattered across it
+    void generate_level(unsigned int columns, unsigned int rows, unsigned int walkers, unsigned int seed = 0);
+
     // Set GLFW callbacks
     void set_callbacks(GLFWcursorposfun cursorpos_callback, GLFWmousebuttonfun cursorbutton_callback, GLFWkeyfun keyboard_callback);
   
@@ -84,6 +170,43 @@ class Game {
     // Store the name of the window
     std::string GameTitle;
 
+    // World states published by the simulation thread for the render thread
+    TripleBuffer<WorldState> WorldStates;
+
+    // Requests from the simulation which must be carried out on the thread owning the window
+    std::atomic<bool> fullscreen_requested { false };
+    std::atomic<bool> close_requested { false };
+
+    // Tells the simulation thread to keep running
+    std::atomic<bool> simulating { false };
+
+    // Held by the simulation thread for the whole of each tick, so the window can be changed in between ticks
+    std::mutex SimulationMutex;
+
+    // The world state the frames are drawn from when the simulation runs on the same thread
+    WorldState LiveState;
+
+    // Pick up any input received by the callbacks since the last update
+    void poll_input();
+
+    // Carry out any window requests made by the simulation
+    void handle_window_requests();
+
+    // Whether the main loop should stop, once the window is closed or every headless frame has been rendered
+    bool should_close();
+
+    // Run the update loop at the fixed tick rate. This is the body of the simulation thread.
+    void simulate();
+
+    // Copy what a frame needs out of the live world into a world state
+    void snapshot(WorldState &state);
+
+    // Snapshot the live world into the back world state and publish it
+    void publish();
+
+    // Build a view of a world state
+    RenderView view(WorldState &state);
+
     // Set all flags/hints for the window
     void set_window_hints();
 
@@ -95,6 +218,41 @@ class Game {
 
     // Load a level from a R* level file
     void load_level(const char *path);
+
+    // Replace the current level with the given rows of tile prefabs
+    void build_level(std::vector<std::vector<std::string>> &instantiation_order);
+
+    // The time spent simulating the crowd since it was last reported
+    double crowd_time = 0.0;
+
+    // The render statistics summed over the frames since they were last reported
+    RenderStats::Totals render_totals;
+
+    // The copy of the world used to predict the player's path, and the path it predicted for this frame
+    Preview::World PreviewWorld;
+    std::vector<glm::vec2> trajectory;
+
+    // Bumped by the simulation whenever a tile moves or the level changes. The render thread compares it against
+    // the revision the tile layer was last built from, and only then looks at the tiles again.
+    unsigned long tile_revision = 1;
+    unsigned long drawn_tile_revision = 0;
+
+    // The tiles the tile layer currently holds
+    std::vector<Sprite> tile_sprites;
+
+    // Collect the active objects whose sprites overlap the camera, sorted by id like GameObjects::all. Candidates
+    // come from the spatial index, which is rebuilt first if a tile moved since it was last built, plus the players,
+    // which are never indexed. Objects outside of the camera's depth range are culled, with a warning the first time.
+    void cull(std::vector<GameObject *> &visible);
+    unsigned long culled_tile_revision = 0;
+    std::vector<GameObject *> cull_candidates;
+    std::unordered_set<unsigned long> depth_warned;
+
+    // The backgrounds only move along with the mouse, so their cached layer is drawn again whenever the mouse moves
+    glm::vec2 background_mouse_position = glm::vec2(-1.0f);
+
+    // Bring the tile layer in line with the tiles of the view, patching the tiles that changed or rebuilding it for a new level
+    void update_tile_layer(RenderView &view);
 };
 
 #endif
@@ -0,0 +1,46 @@
+#ifndef __GL_STATE_H__
+#define __GL_STATE_H__
+
+#include "glad/gl.h"
+
+#include "render_stats.h"
+
+// This namespace keeps track of the GL state the renderers change, and drops any call that would set a piece of state
+// to the value it already has. Every bind has to go through here for the tracked state to stay correct.
+namespace GLState {
+  // The number of texture units whose bindings are tracked
+  const unsigned int TEXTURE_UNITS = 4;
+
+  // Bind a program, vertex array or buffer, unless it is bound already
+  void use_program(unsigned int program);
+  void bind_vertex_array(unsigned int vao);
+  void bind_buffer(GLenum target, unsigned int buffer);
+
+  // Bind a GL_TEXTURE_2D or GL_TEXTURE_2D_ARRAY texture to the given texture unit, switching units only if needed
+  void bind_texture(unsigned int unit, GLenum target, unsigned int texture);
+
+  // Bind a texture to the first texture unit and make that unit the active one, so the texture can be uploaded to
+  void edit_texture(GLenum target, unsigned int texture);
+
+  // Bind a framebuffer for both drawing and reading, unless it is bound already. The framebuffer 0 stands for the screen.
+  void bind_framebuffer(unsigned int framebuffer);
+
+  // Set the framebuffer that is the screen, for when there is no window to provide one (see Headless)
+  void set_screen_framebuffer(unsigned int framebuffer);
+
+  // Turn blending on or off, and set the blend function. The alpha channel is blended separately, and by default it
+  // accumulates coverage, so that anything drawn into a transparent framebuffer ends up with premultiplied alpha.
+  void blend(bool enabled, GLenum source = GL_SRC_ALPHA, GLenum destination = GL_ONE_MINUS_SRC_ALPHA, GLenum source_alpha = GL_ONE, GLenum destination_alpha = GL_ONE_MINUS_SRC_ALPHA);
+
+  // Forget about objects that are about to be deleted, as GL reuses the names of deleted objects
+  void forget_program(unsigned int program);
+  void forget_vertex_array(unsigned int vao);
+  void forget_buffer(unsigned int buffer);
+  void forget_texture(unsigned int texture);
+  void forget_framebuffer(unsigned int framebuffer);
+
+  // Forget everything, for when the state may have been changed behind the cache's back
+  void invalidate();
+}
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef __HEADLESS_H__
+#define __HEADLESS_H__
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+#include "glad/gl.h"
+
+#include "gl_state.h"
+
+// This namespace runs the game without a window, for machines without a display (or a GPU). The context comes straight
+// from EGL, preferably on Mesa's surfaceless platform, and the frames are drawn into a framebuffer of the backend's own
+// instead of a window, which is what binding the framebuffer 0 through GLState stands for. Each frame can be written
+// out as a PNG once it is done, so the frames can be compared against golden images.
+namespace Headless {
+  // Whether to run headless, the number of frames to render before closing, and the directory to write every
+  // dump_every-th frame to (none if empty). These have to be set before the game is created.
+  extern bool enabled;
+  extern unsigned int frames;
+  extern std::string dump_directory;
+  extern unsigned int dump_every;
+
+  // The number of frames finished so far
+  extern unsigned int frame;
+
+  // Create an OpenGL 3.3 core context, load GL through it, and create the framebuffer to render into.
+  // Returns false if any of it failed.
+  bool init(unsigned int width, unsigned int height);
+  void destroy();
+
+  // Finish the current frame in place of swapping buffers, dumping it if it is due
+  void swap();
+
+  // Whether every frame asked for has been rendered
+  bool done();
+
+  // Write an image, given as rows of RGB pixels from the top down, to an (uncompressed) PNG file
+  bool write_png(const std::string &path, unsigned int width, unsigned int height, const std::vector<uint8_t> &pixels);
+}
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef __JOBS_H__
+#define __JOBS_H__
+
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <vector>
+
+// This namespace runs batches of independent work across a pool of worker threads.
+// The pool is started the first time it is needed and lives until it is shut down.
+namespace Jobs {
+  // Call the function over the range [0, count), split into chunks of `grain` items that are handed out to
+  // the worker threads and the calling thread alike. Returns once every chunk has been processed.
+  // Small batches are run directly on the calling thread, as waking the workers would cost more than it saves.
+  void parallel_for(unsigned int count, std::function<void(unsigned int begin, unsigned int end)> function, unsigned int grain = 256);
+
+  // The number of threads (including the calling thread) that batches are spread across
+  unsigned int concurrency();
+
+  // Stop the workers and wait for them to return. No batch may be running. The pool starts again if it is needed later.
+  void shutdown();
+}
+
+#endif
@@ -6,16 +6,40 @@
 #include <vector>
 #include <algorithm>
 #include <cmath>
+#include <functional>
 
 #include "camera.h"
 #include "glm/glm.hpp"
 
 #include "texture.h"
 #include "sprite.h"
+#include "render_queue.h"
+#include "debug_draw.h"
 #include "utils.h"
 #include "physics.h"
 #include "resource_manager.h"
 
+// The part of a GameObject needed to draw it, copied out of the live world so that a frame can be drawn from it
+// while the simulation moves on. It holds no pointers or strings, so copying it never allocates.
+typedef struct ObjectSnapshot {
+  unsigned long id = 0;
+  Transform transform;
+  glm::vec3 position_offset = glm::vec3(0.0f);
+  glm::vec2 origin = glm::vec2(0.0f);
+  BoundingBox bounding_box;
+
+  // The texture of the current frame, and the transform it is drawn with (see GameObject::render_transform)
+  Texture texture;
+  Transform render_transform;
+
+  // Tiles are drawn by the tile layer, immovable tiles without the tint of the movable or locked ones
+  bool tile = false, immovable = false, locked = false;
+  bool collider_revealed = false;
+
+  // Queue the snapshot to be drawn, like GameObject::render
+  void render(glm::vec4 colour = glm::vec4(1.0f), int focus = 0, unsigned int layer = RENDER_OBJECTS) const;
+} ObjectSnapshot;
+
 // This class handles all game objects, containing boilerplate code for
 // collision detection or motion or anything else an object might need.
 // For complex object interactions, usage of this namespace is recommended
@@ -73,6 +97,25 @@ class GameObject {
     // Locked controls whether the tile can move at all or not. This includes swapping and everything.
     bool locked = false;
 
+    // Dynamic rigidbodies are moved by the integrator every tick, instead of staying wherever they were placed
+    bool dynamic = false;
+
+    // The velocity of a dynamic object. Like the acceleration and the impulse, it points upwards.
+    glm::vec2 velocity = glm::vec2(0.0f);
+
+    // The acceleration will be added to the velocity each tick. This is the gravity of the object, and
+    // each object can fall in its own direction.
+    glm::vec2 acceleration = glm::vec2(0.0f, -10.0f);
+
+    // The impulse force will apply for one tick only
+    glm::vec2 impulse = glm::vec2(0.0f);
+
+    // The speed the object walks with. It moves the object without ever being accumulated into the velocity.
+    float walk_speed = 0.0f;
+
+    // Is the object resting on top of something?
+    bool grounded = false;
+
     // Should the collider be revealed?
     // Tip: This is a debug function
     bool collider_revealed = false;
@@ -93,8 +136,20 @@ class GameObject {
     // Create an empty constructor for an object, as otherwise it won't play nice with std::map
     GameObject() { }
 
-    // Actually render the GameObject using a SpriteRenderer
-    void render(glm::vec4 colour = glm::vec4(1.0f), int focus = 0);
+    // Objects are deleted through GameObject pointers, even when they are a derived class like Player
+    virtual ~GameObject() { }
+
+    // Queue the GameObject to be drawn on the given layer (see RenderQueue), ordered by its z-index within the layer
+    void render(glm::vec4 colour = glm::vec4(1.0f), int focus = 0, unsigned int layer = RENDER_OBJECTS);
+
+    // The transform the GameObject is rendered with, including its position offset and flips
+    Transform render_transform();
+
+    // The area the rendered sprite covers, which may reach past the bounding box of the collider
+    BoundingBox render_bounds();
+
+    // Copy what is needed to draw the object
+    ObjectSnapshot snapshot();
 
     // Translate the object to a given point
     void translate(glm::vec2 point);
@@ -113,6 +168,9 @@ class GameObject {
     // Check collision between two bounding boxes
     Collision check_collision(GameObject *object);
 
+    // Push a dynamic object out of the static rigidbodies it has moved into, grounding it if it landed on one
+    void settle();
+
     // Update the bounding box according to the new position of the object
     void update_bounding_box();
 
@@ -122,8 +180,11 @@ class GameObject {
 
 // This namespace handles generic functions related to dealing with GameObjects
 namespace GameObjects {
-  // Externally declare the main Renderer and the Camera
+  // Externally declare the main Renderer and the Camera.
+  // GameObjects are queued in the Queue, which draws them through the Batch once it is flushed.
   extern SpriteRenderer *Renderer;
+  extern SpriteBatch *Batch;
+  extern RenderQueue *Queue;
   extern OrthoCamera *Camera;
 
   // This namespace handles creating and dealing with Prefabs
@@ -147,6 +208,9 @@ namespace GameObjects {
   GameObject *instantiate(std::string prefab_handle, Transform transform);
   GameObject *instantiate(GameObject prefab, Transform transform);
 
+  // Take ownership of an object allocated elsewhere (like a Player), giving it an id and storing it with all other objects
+  GameObject *adopt(GameObject *object);
+
   // Delete an instantiated object (only removes the object and not the prefab)
   void uninstantiate(std::string handle);
   void uninstantiate(unsigned long id);
@@ -157,6 +221,37 @@ namespace GameObjects {
   // Fetch a vector with a pointer to all active GameObjects
   std::vector<GameObject *> all();
 
+  // Rebuild the spatial indices over all active objects except for the players, one over their colliders and one
+  // over their sprites. This must be called whenever the indexed objects have moved, before querying them.
+  void index();
+
+  // Append every indexed object whose bounding box might overlap the given area
+  void query(BoundingBox area, std::vector<GameObject *> &out);
+
+  // Append every indexed object whose sprite (see GameObject::render_bounds) might overlap the given area
+  void query_sprites(BoundingBox area, std::vector<GameObject *> &out);
+
+  // The closest object hit by a cast, how far along the cast it was hit, and the normal of the side that was hit
+  typedef struct Hit {
+    GameObject *object = nullptr;
+    float distance = 0.0f;
+    glm::vec2 point = glm::vec2(0.0f);
+    glm::vec2 normal = glm::vec2(0.0f);
+  } Hit;
+
+  // Find the closest indexed object hit by a ray, a segment or a box swept along a direction, ignoring any object
+  // the filter rejects. These go through the spatial index, so it must be up to date before calling them.
+  bool raycast(glm::vec2 origin, glm::vec2 direction, float max_distance, Hit &hit, std::function<bool(GameObject *)> filter = nullptr);
+  bool segment(glm::vec2 from, glm::vec2 to, Hit &hit, std::function<bool(GameObject *)> filter = nullptr);
+  bool boxcast(BoundingBox box, glm::vec2 direction, float max_distance, Hit &hit, std::function<bool(GameObject *)> filter = nullptr);
+
+  // Check whether an object is standing on an indexed rigidbody, in the direction of its own gravity
+  bool grounded(GameObject *object);
+
+  // Move every dynamic rigidbody by a single tick in one pass, then settle all of them except for the players,
+  // which resolve their own collisions. The spatial index must be up to date before calling this.
+  void integrate();
+
   // Filter all the GameObjects and return a vector with a pointer to active filtered GameObjects
   // Note: Any operation involving filtering is very performance-hungry and its use should be minimised
   std::vector<GameObject *> filter(std::string tag);
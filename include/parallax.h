@@ -0,0 +1,44 @@
+#ifndef __PARALLAX_H__
+#define __PARALLAX_H__
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+
+#include "glad/gl.h"
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+
+#include "shader.h"
+#include "texture.h"
+#include "gl_state.h"
+#include "render_stats.h"
+#include "resource_manager.h"
+
+// This namespace draws the parallax background in a single pass. One full-screen quad samples every layer and blends
+// them together in the shader, so each pixel of the background is written once instead of once per layer.
+namespace Parallax {
+  // The most layers the shader samples, one per tracked texture unit
+  const unsigned int MAX_LAYERS = 4;
+
+  // How much wider and taller than the screen every layer is stretched, so that moving it never uncovers an edge
+  const float OVERSCAN = 100.0f;
+
+  // A layer of the background. It moves by a pixel for every `distance` pixels the mouse moves (or stays still for a
+  // distance of 0), and starts `margin` pixels past the top-left corner of the screen.
+  typedef struct Layer {
+    Texture texture;
+    float distance;
+    float margin;
+  } Layer;
+
+  // Load the layers from a given R* parallax file, with the textures already loaded, and the shader drawing them
+  void load_from_file(const char *file_path, Shader shader);
+
+  // Draw the background for the given mouse position over a screen of the given size
+  void render(glm::vec2 mouse_position, glm::vec2 screen_size);
+}
+
+#endif
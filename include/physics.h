@@ -1,6 +1,13 @@
 #ifndef __PHYSICS_H__
 #define __PHYSICS_H__
 
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <limits>
+
 #include "glm/glm.hpp"
 
 // Directional enum to handle collision direction
@@ -65,4 +72,128 @@ typedef struct Collision {
     bool collision;
 };
 
+// This namespace holds the settings shared by the whole physics simulation
+namespace Physics {
+  // Check whether a body (given by its bounding box, offset position and scale) is colliding with another one.
+  // The MTVs are measured from the first body, like GameObject::check_collision measures them from itself.
+  Collision collide(BoundingBox box, glm::vec2 position, glm::vec2 scale, BoundingBox other_box, glm::vec2 other_position, glm::vec2 other_scale);
+
+  // The closest item hit by a ray or a cast box. The point is where the centre of the cast was at the time of
+  // impact, and the normal is the side of the item that was hit (in world space, where y grows downwards).
+  typedef struct Hit {
+    unsigned int item = 0;
+    float distance = 0.0f;
+    glm::vec2 point = glm::vec2(0.0f);
+    glm::vec2 normal = glm::vec2(0.0f);
+  } Hit;
+
+  // A uniform grid over the world, used as the broadphase for collision and other spatial queries.
+  // Items are referred to by an index into an array owned by whoever fills the grid.
+  class SpatialGrid {
+    public:
+      // The size of each (square) cell of the grid
+      float cell_size;
+
+      SpatialGrid(float cell_size = 128.0f) : cell_size(cell_size), columns(0), rows(0) { }
+
+      // Remove every item and resize the grid to cover the given area.
+      // Items outside of the area are still found, they are just clamped into the border cells.
+      void clear(BoundingBox area);
+
+      // Add an item covering the given bounding box
+      void insert(unsigned int item, BoundingBox box);
+
+      // Append every item whose cells overlap the given bounding box, sorted and without duplicates.
+      // Queries only read the grid, so they are safe to run from several threads at once.
+      void query(BoundingBox box, std::vector<unsigned int> &out) const;
+
+      // Find the closest item hit by a ray, a segment, or a box swept along a direction, skipping any item the
+      // filter rejects. Items the cast starts inside of are never hit. The cast walks through the grid one cell
+      // at a time, and stops as soon as nothing further along could be any closer than what it has hit.
+      bool raycast(glm::vec2 origin, glm::vec2 direction, float max_distance, Hit &hit, const std::function<bool(unsigned int)> &filter = nullptr) const;
+      bool segment(glm::vec2 from, glm::vec2 to, Hit &hit, const std::function<bool(unsigned int)> &filter = nullptr) const;
+      bool boxcast(BoundingBox box, glm::vec2 direction, float max_distance, Hit &hit, const std::function<bool(unsigned int)> &filter = nullptr) const;
+
+    private:
+      BoundingBox area;
+      int columns, rows;
+      std::vector<std::vector<unsigned int>> cells;
+
+      // The bounding box of each item, used by the casts
+      std::vector<BoundingBox> boxes;
+
+      // Convert a bounding box to the range of cells it covers
+      void cell_range(BoundingBox box, int &left, int &top, int &right, int &bottom) const;
+  };
+
+  // How far past its feet a body looks for the ground it is standing on, and how far above its feet the look starts.
+  // Casts never hit what they start inside of, so the skin is how far a body can sink into the ground and still stand on it.
+  const float GROUND_PROBE = 1.0f;
+  const float GROUND_SKIN = 8.0f;
+
+  // Check whether a body is standing on an item of the grid, by casting its feet along its gravity from just inside of
+  // the body to just past it. As accelerations point upwards, a negative gravity pulls the body down.
+  bool grounded(const SpatialGrid &grid, BoundingBox box, float gravity, const std::function<bool(unsigned int)> &filter = nullptr);
+
+  // The simulation always advances in fixed ticks, independent of the frame rate
+  const int TICK_RATE = 60;
+  const double TICK = 1.0 / TICK_RATE;
+
+  // In deterministic mode every position, velocity and MTV is snapped onto a fixed-point
+  // grid so that the same inputs produce bit-identical runs on every machine and build
+  extern bool deterministic;
+
+  // The number of ticks simulated so far and the checksum of the world after the last one
+  extern unsigned long tick_count;
+  extern uint64_t checksum;
+
+  // Print the checksum after every tick, so runs can be diffed tick by tick
+  extern bool trace_checksums;
+
+  // Values are stored as 24.8 fixed-point numbers. With 8 fractional bits, every fixed-point
+  // value within the playing field fits inside a float's mantissa, so conversions are lossless.
+  typedef int32_t fixed;
+  const int FIXED_SHIFT = 8;
+  const float FIXED_ONE = (float)(1 << FIXED_SHIFT);
+
+  // Convert between floats and fixed-point numbers, rounding to the nearest fixed-point value
+  inline fixed to_fixed(float value) { return (fixed)std::lround(value * FIXED_ONE); }
+  inline float to_float(fixed value) { return (float)value / FIXED_ONE; }
+
+  // Divide a fixed-point value by a (positive) integer, rounding to the nearest value with halves away from zero like
+  // to_fixed does. Integer division truncates towards zero instead, which cuts up to a whole unit off every step.
+  inline fixed divide(fixed value, int divisor) { return (value >= 0 ? value + divisor / 2 : value - divisor / 2) / divisor; }
+
+  // Snap a value onto the fixed-point grid in deterministic mode, otherwise return it untouched
+  float quantize(float value);
+  glm::vec2 quantize(glm::vec2 value);
+  glm::vec3 quantize(glm::vec3 value);
+
+  // Fold a fixed-point value into a running FNV-1a checksum
+  const uint64_t CHECKSUM_SEED = 0xcbf29ce484222325ULL;
+  uint64_t hash(uint64_t checksum, fixed value);
+
+  // The state of every dynamic body, stored as one array per component so that the integrator can
+  // sweep through each of them linearly. Velocities point upwards, while positions grow downwards.
+  typedef struct Bodies {
+    std::vector<float> position_x, position_y;
+    std::vector<float> velocity_x, velocity_y;
+    std::vector<float> acceleration_x, acceleration_y;
+    std::vector<float> impulse_x, impulse_y;
+
+    // A constant horizontal speed (like walking) that moves the body without accumulating into its velocity
+    std::vector<float> drive_x;
+
+    // Grounded bodies have their vertical velocity reset before the acceleration is applied
+    std::vector<uint8_t> grounded;
+
+    // Resize every component array at once
+    void resize(unsigned int size);
+    unsigned int size() const { return this->position_x.size(); }
+  } Bodies;
+
+  // Advance the bodies in the given range by a single tick, consuming their impulses
+  void integrate(Bodies &bodies, unsigned int begin, unsigned int end);
+}
+
 #endif
@@ -14,49 +14,54 @@
 #include "object.h"
 #include "resource_manager.h"
 #include "texture.h"
+#include "jobs.h"
+
+// An object a player touched, and how the two collided
+typedef struct Contact {
+  Contact(GameObject *_object, Collision _collision) : object{_object}, collision{_collision} { }
+
+  GameObject *object;
+  Collision collision;
+};
 
 // Create a Player class to handle any and all player-related code 
 class Player : public GameObject {
   public:
-    // The velocity acting on the player at every frame
-    glm::vec2 velocity = glm::vec2(0.0f);
-
-    // The acceleration will be added to the velocity each frame
-    glm::vec2 acceleration = glm::vec2(0.0f, -10.0f);
-
-    // The impulse force will apply for one frame only
-    glm::vec2 impulse = glm::vec2(0.0f, 5.0f);
-
-    // The walk speed the player walks with
-    float walk_speed = 100.0f;
-
-    // Is the object grounded?
-    bool grounded = false;
-
     // Did the player win?
     bool won = false;
 
     // Did the player die?
     bool die = false;
 
+    // The goal the player reached during the last tick, if any
+    GameObject *goal = nullptr;
+
+    // Everything the player touched during the last tick. The collisions are checked once per tick while
+    // resolving them, and cached here for everything else that needs to know what the player is touching.
+    std::vector<Contact> contacts;
+
     // Animation related variables 
     float fps = 100.0f;
     float animation_timer = this->fps;
 
-    // Empty construtor
-    Player() { }
+    // Players are dynamic bodies which start off with a small hop and walk on their own
+    Player() {
+      this->dynamic = true;
+      this->impulse = glm::vec2(0.0f, 5.0f);
+      this->walk_speed = 100.0f;
+    }
 
     // Update the player every frame
     void update();
 
-    // Resolve forces and vectors
-    void resolve_vectors();
-
     // Resolve all collisions with other objects
     void resolve_collisions();
 
-    // Update the animation state
-    void animate();
+    // Check whether the player touched the given object during the last tick
+    bool touching(GameObject *object);
+
+    // Update the animation state by the given time in seconds
+    void animate(double delta);
 };
 
 // When handling GameObjects gets too annoying and more control over
@@ -65,17 +70,27 @@ class Player : public GameObject {
 // or a mob/NPC controller.
 namespace Characters {
   namespace Players {
-    // Keep track of all the players created
-    static std::map<std::string, Player> Players;
+    // Keep track of all the players created.
+    // The players themselves are stored and owned by GameObjects, along with every other object.
+    extern std::vector<Player *> Players;
 
-    // Assign a static, active player
-    static Player *ActivePlayer;
+    // The player controlled by the user
+    extern Player *ActivePlayer;
 
     // Create a Player by providing all the required parameters
     Player *create(const char *handle, std::vector<Texture> texture, Transform transform = Transform(), std::vector<std::string> tags = std::vector<std::string>());
     Player *create(const char *handle, Texture texture, Transform transform = Transform(), std::vector<std::string> tags = std::vector<std::string>());
 
     std::vector<Player *> all();
+
+    // Delete every player except for the active player
+    void clear();
+
+    // Advance every player by a single tick, after the integrator has moved them. Each stage runs over all
+    // the players in parallel, and finishes before the next stage starts. The spatial index must be up to
+    // date before calling this. While paused (for example while a tile is being dragged), the players are
+    // only kept in bounds.
+    void step(bool paused = false);
   }
 };
 
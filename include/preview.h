@@ -0,0 +1,78 @@
+#ifndef __PREVIEW_H__
+#define __PREVIEW_H__
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+#include "glad/gl.h"
+#include "glm/glm.hpp"
+
+#include "physics.h"
+#include "object.h"
+#include "player.h"
+#include "resource_manager.h"
+#include "stream_buffer.h"
+
+// This namespace predicts where the active player will walk by fast-forwarding a copy of the world.
+// The copy only holds plain collision data (no strings, textures or pointers into the real world),
+// so it is cheap to clone every frame and can be stepped without touching any real object.
+namespace Preview {
+  // What touching a collider does to the walker, decided from the tags of the object it was copied from
+  typedef enum ColliderKind {
+    COLLIDER_OTHER,
+    COLLIDER_TILE,
+    COLLIDER_SAFE,
+    COLLIDER_DANGER,
+    COLLIDER_GOAL
+  } ColliderKind;
+
+  // A static object, reduced to what the walker's collisions read
+  typedef struct Collider {
+    BoundingBox bounding_box;
+
+    // The position already includes the object's position offset
+    glm::vec2 position;
+    glm::vec2 scale;
+
+    ColliderKind kind;
+    bool rigidbody;
+  } Collider;
+
+  // The walker being predicted
+  typedef struct Walker {
+    BoundingBox bounding_box;
+    glm::vec2 position;
+    glm::vec2 scale;
+    bool grounded, won, die;
+  } Walker;
+
+  // A physics-only copy of the world
+  typedef struct World {
+    std::vector<Collider> colliders;
+    Physics::SpatialGrid grid;
+    glm::vec2 size;
+
+    // The walker is integrated by the same integrator as the real world, so it is kept as a single body
+    Walker walker;
+    Physics::Bodies body;
+
+    // Scratch space for the grid queries, kept around to avoid allocating every tick
+    std::vector<unsigned int> nearby;
+  } World;
+
+  // Copy the world as it would be if the dragged object was dropped right now, with the given player as the walker
+  void clone(World &world, Player *player, GameObject *dragged);
+
+  // Advance the copy by a single tick, mirroring Player::update and Player::resolve_collisions.
+  // Returns false once the walker has either won or died, as it stops moving from then on.
+  bool step(World &world);
+
+  // Step the copy up to the given number of ticks, replacing the path with the centre of the walker after each one
+  void simulate(World &world, unsigned int ticks, std::vector<glm::vec2> &path);
+
+  // Draw a path as a polyline in world space
+  void render(const std::vector<glm::vec2> &path, glm::vec4 colour);
+}
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef __RENDER_QUEUE_H__
+#define __RENDER_QUEUE_H__
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <functional>
+
+#include "glm/glm.hpp"
+
+#include "sprite.h"
+#include "texture.h"
+#include "utils.h"
+
+// The layers of a frame, drawn from back to front
+typedef enum RenderLayer {
+  RENDER_BACKGROUND,
+  RENDER_OBJECTS,
+  RENDER_TILES,
+  RENDER_PREVIEW,
+  RENDER_PLAYER,
+  RENDER_FOCUSED,
+  RENDER_DRAGGED,
+  RENDER_DRAGGED_PLAYER,
+  RENDER_DEBUG,
+  RENDER_TEXT
+} RenderLayer;
+
+// Collects everything drawn in a frame, then draws it in order of a 64-bit key packing (from the most to the least
+// significant bits) the layer, the depth, the shader and the texture of each item. Within a layer and depth, items
+// sharing a shader and texture end up next to each other, so the batch behind the queue changes state as rarely as
+// possible. Items with the same key are drawn in the order they were submitted.
+class RenderQueue {
+  public:
+    // The number of bits of each field of the key
+    static const int LAYER_BITS = 8, DEPTH_BITS = 24, SHADER_BITS = 8, TEXTURE_BITS = 24;
+
+    // Pack a key. Lower depths are drawn first, and only the highest bits of the depth are kept.
+    static uint64_t key(unsigned int layer, float depth, unsigned int shader, unsigned int texture);
+
+    // The sprites are drawn through the given batch
+    RenderQueue(SpriteBatch *batch, unsigned int shader);
+
+    // Queue a sprite, taking the same arguments as SpriteBatch::render
+    void submit(unsigned int layer, float depth, Texture texture, Transform transform, glm::vec4 colour = glm::vec4(1.0f), int focus = 0);
+
+    // Queue anything drawn without the batch (text, lines, retained layers, ...), along with the shader it draws with
+    void submit(unsigned int layer, float depth, unsigned int shader, std::function<void()> draw);
+
+    // Sort and draw every queued item, and empty the queue
+    void flush();
+
+    // The number of items queued
+    unsigned int size() const { return this->entries.size(); }
+
+  private:
+    // The key of an item, and where the item is in the list of sprites or the list of draws
+    typedef struct Entry {
+      uint64_t key;
+      unsigned int item;
+      bool draw;
+    } Entry;
+
+    SpriteBatch *batch;
+    unsigned int shader;
+
+    std::vector<Sprite> sprites;
+    std::vector<std::function<void()>> draws;
+    std::vector<Entry> entries, scratch;
+
+    // Sort the entries by key with a (stable) least significant digit radix sort, a byte at a time
+    void sort();
+};
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef __RENDER_STATS_H__
+#define __RENDER_STATS_H__
+
+#include <cstdio>
+
+// Counters describing how much work the renderer submitted for the current frame
+namespace RenderStats {
+  // The number of draw calls issued and sprites drawn
+  extern unsigned int draw_calls;
+  extern unsigned int sprites;
+
+  // The number of objects and strings drawn, and the number skipped as they were outside of the camera
+  extern unsigned int visible;
+  extern unsigned int culled;
+
+  // The number of pixels covered by the sprites and layers drawn, each clipped to the screen. Overdraw is counted once
+  // for every time a pixel is drawn over, so a frame drawing the whole screen twice fills two screens of pixels.
+  extern unsigned long fill;
+
+  // The number of uniforms set, and how many of those actually reached GL as their value had changed
+  extern unsigned int uniforms_set;
+  extern unsigned int uniform_uploads;
+
+  // The number of binds and other state changes made, and how many were dropped by GLState as they changed nothing
+  extern unsigned int state_calls;
+  extern unsigned int state_elided;
+
+  // The number of bytes of vertices streamed to the GPU, and the CPU time spent copying them there, in seconds
+  extern unsigned long uploaded;
+  extern double upload_time;
+
+  // The CPU time spent submitting the frame, in seconds
+  extern double submit_time;
+
+  // Reset the counters at the start of a frame
+  void reset();
+
+  // The counters summed over several frames, to report their averages
+  typedef struct Totals {
+    unsigned long frames = 0;
+    unsigned long draw_calls = 0, sprites = 0;
+    unsigned long visible = 0, culled = 0;
+    unsigned long fill = 0;
+    unsigned long uniforms_set = 0, uniform_uploads = 0;
+    unsigned long state_calls = 0, state_elided = 0;
+    unsigned long uploaded = 0;
+    double upload_time = 0.0, submit_time = 0.0;
+
+    // Add the counters of the frame that was just submitted
+    void add();
+
+    // Print the averages per frame, as a line starting with the given prefix and name
+    void report(const char *prefix, const char *name) const;
+  } Totals;
+}
+
+#endif
@@ -14,6 +14,8 @@
 #include <fstream>
 #include <stdio.h>
 #include <algorithm>
+#include <vector>
+#include <chrono>
 
 #define FILTER_NEAREST 0
 #define FILTER_LINEAR 1
@@ -44,16 +46,50 @@ namespace ResourceManager {
     // Loads an image from a file, creating a new texture object in the resource manager
     ::Texture load(const char *file_path, bool alpha, std::string handle);
 
+    // Loads the frames of an animation as the layers of a single array texture, adding each frame to the resource
+    // manager as "<handle>-<frame>". Frames which are not all the same size are loaded as separate textures instead.
+    std::vector<::Texture> load_frames(std::vector<std::string> file_paths, bool alpha, std::string handle);
+
     // Fetches a texture using the given handle
     ::Texture get(std::string handle);
 
     // Deallocates a texture with the given handle
     void deallocate(std::string handle);
 
-    // Load all textures from a given R* textures file
+    // Load all textures from a given R* textures file.
+    // Unless they opt out, the textures are packed into atlases (see ResourceManager::Atlas).
     void load_from_file(const char *file_path);
   }
 
+  // Packs many small textures into a few large ones, so that sprites using different textures can still be drawn together
+  namespace Atlas {
+    // Whether textures loaded from R* files are packed at all (turned off by the --no-atlas flag)
+    extern bool enabled;
+
+    // The largest width and height of a single atlas
+    const int MAX_SIZE = 2048;
+
+    // The gap left around every packed image. It is filled by stretching the edges of the image outwards,
+    // so that filtering at the edge of an image never samples its neighbour.
+    const int PADDING = 2;
+
+    // An image waiting to be packed, as loaded by ResourceManager::Image::load
+    typedef struct Image {
+      std::string handle;
+      unsigned char *data;
+      int width, height;
+      bool alpha;
+    } Image;
+
+    // Pack the images into as few atlases as possible, and add a texture for each image to the resource manager.
+    // Only images with the same settings share an atlas, and images too large for an atlas get a texture of their own.
+    void pack(std::vector<Image> &images);
+
+    // Deallocate every shared texture, which are the atlas pages and the arrays of animation frames.
+    // ResourceManager::Texture::deallocate leaves these alone, as other textures still draw from them.
+    void deallocate();
+  }
+
   // Manages loading and deallocating image files.
   // ResourceManager::Texture uses functions from this namespace.
   namespace Image {
@@ -70,9 +106,9 @@ namespace ResourceManager {
     // The current active list of characters
     extern std::map<char, Character> Characters;
 
-    // Load a new font.
+    // Load a new font, as an atlas of the signed distance fields of its glyphs (see Fonts::SDF_SPREAD).
     // NOTE: Only one font is supported. Loading another font will overwrite existing font.
-    void load(const char *file_path, std::string font_name, unsigned int num_chars, short filtering = FILTER_LINEAR);
+    void load(const char *file_path, std::string font_name, unsigned int num_chars);
   }
 
   // // Manages loading and reading all files like level maps or required resource or prefabs
@@ -7,12 +7,33 @@
 
 #include <string>
 #include <fstream>
+#include <vector>
+#include <map>
+#include <memory>
+#include <cstring>
+
+#include "render_stats.h"
+#include "gl_state.h"
+
+// Uniforms are referred to by an id rather than by their name, so that setting them needs no string lookups.
+// Ids are handed out once per name by Shader::uniform and are the same in every shader.
+typedef unsigned int UniformId;
+
+// The binding points of the uniform blocks shared by every shader. Blocks are matched to their binding point by name
+// when a shader is linked, as GLSL 3.30 cannot set the binding in the shader itself.
+namespace UniformBlocks {
+  // The camera's projection and view matrix, see Camera::bind
+  const unsigned int CAMERA = 0;
+}
 
 class Shader {
   public:
     // The ID of the shader
     unsigned int id;
 
+    // Get the id of the uniform with the given name, handing out a new one the first time the name is seen
+    static UniformId uniform(const char *name);
+
     // For std::map to work (see resource_manager.h), the constructor needs to take no parameters
     Shader() { }
 
@@ -23,7 +44,16 @@ class Shader {
     // Activate or deactivate the shader
     void activate();
 
-    // Modify a uniform in the shader
+    // Modify a uniform in the shader. Values equal to what the uniform was last set to are not uploaded again.
+    void set_bool       (UniformId uniform, bool value);
+    void set_float      (UniformId uniform, float value);
+    void set_integer    (UniformId uniform, int value);
+    void set_vector_2f  (UniformId uniform, const glm::vec2 &value);
+    void set_vector_3f  (UniformId uniform, const glm::vec3 &value);
+    void set_vector_4f  (UniformId uniform, const glm::vec4 &value);
+    void set_matrix_4f  (UniformId uniform, const glm::mat4 &value);
+
+    // The same setters taking the name of the uniform, for uniforms which are rarely set
     void set_bool       (const char *handle, bool value);
     void set_float      (const char *handle, float value);
     void set_integer    (const char *handle, int value);
@@ -36,8 +66,36 @@ class Shader {
     void set_matrix_4f  (const char *handle, const glm::mat4 &value);
 
   private:
+    // What is known about each uniform of the linked program, indexed by the uniform's id
+    typedef struct UniformSlot {
+      int location = -1;
+      bool warned = false;
+
+      // The value the uniform was last set to, kept as raw bytes so that any type can be compared
+      bool cached = false;
+      unsigned char value[sizeof(glm::mat4)];
+    } UniformSlot;
+
+    // The uniform table is shared by every copy of the shader, as shaders are passed around by value
+    std::shared_ptr<std::vector<UniformSlot>> uniforms;
+
     // Checks the shader files and prints out errors if any are found
     void compile_errors(unsigned int shader, const char *type);
+
+    // Look up every active uniform of the linked program
+    void reflect();
+
+    // Find the location a value has to be uploaded to, remembering the value. Returns -1 if the value is unchanged,
+    // or if the program has no such uniform (which is warned about once).
+    int upload_location(UniformId uniform, const void *value, std::size_t size);
 };
 
+// The ids of the uniforms the renderers set every frame
+namespace Uniforms {
+  extern const UniformId MODEL;
+  extern const UniformId COLOUR, FOCUS, REGION;
+  extern const UniformId SPRITE, FRAMES, LAYER;
+  extern const UniformId TEXT_COLOUR;
+}
+
 #endif
@@ -5,11 +5,19 @@
 #include "texture.h"
 #include "camera.h"
 #include "utils.h"
+#include "render_stats.h"
+#include "stream_buffer.h"
 
 #include "glm/glm.hpp"
 #include "glm/gtc/matrix_transform.hpp"
 #include "glad/gl.h"
 
+#include <vector>
+#include <map>
+#include <cmath>
+#include <cstddef>
+#include <algorithm>
+
 class SpriteRenderer {
   public:
     // The constructor initialises the shader and the shape of the sprite
@@ -28,4 +36,110 @@ class SpriteRenderer {
     unsigned int vao, ebo;
 };
 
+// The layout of a single vertex of the sprites drawn by the batch and the layers.
+// Each sprite is a quad of four of these, so that many sprites can be drawn at once.
+typedef struct SpriteVertex {
+  glm::vec2 position;
+  glm::vec2 texture_coordinate;
+
+  // The position of the vertex within its sprite from (0, 0) to (1, 1), which the texture coordinate no longer is
+  // for a texture packed into an atlas. It is what the border highlight of focused sprites is drawn from.
+  glm::vec2 local_coordinate;
+  glm::vec4 colour;
+  float focus;
+
+  // The layer of the array texture holding the sprite's frame, or -1 for a regular texture
+  float layer;
+} SpriteVertex;
+
+// A sprite to be kept in a SpriteLayer (identified by a key chosen by whoever fills the layer) or a RenderQueue
+typedef struct Sprite {
+  unsigned long key;
+  Texture texture;
+  Transform transform;
+  glm::vec4 colour;
+  int focus;
+} Sprite;
+
+// Work out the four corners of a sprite in world space, the same way SpriteRenderer::render transforms them,
+// with the texture coordinates covering the region of the texture (see Texture::uv) and the layer of its frame
+void sprite_quad(Transform transform, const Texture &texture, glm::vec4 colour, int focus, SpriteVertex *quad);
+
+// Set up the vertex attributes of a VAO for buffers of SpriteVertex, with the VAO and the buffers already bound
+void sprite_attributes();
+
+// Every sprite is a quad made of two triangles, so the indices of any number of sprites can be generated up front
+std::vector<unsigned int> sprite_indices(unsigned int count);
+
+// Draws sprites by accumulating their quads into a single streamed vertex buffer.
+// A batch samples one regular texture and one array texture (for animation frames), so the quads are only sent to
+// the GPU when either of those changes, when the buffer is full, or when the batch is flushed. Consecutive sprites
+// sharing a texture, or switching between the frames of an animation, cost a single draw call. Anything drawn without the batch
+// (text, lines, ...) must flush it first, otherwise it ends up underneath the sprites queued before it.
+class SpriteBatch {
+  public:
+    // The constructor creates an index buffer large enough for the given number of sprites per draw call. Their
+    // vertices are streamed through StreamBuffer, which has to be initialised first.
+    SpriteBatch(Shader &shader, OrthoCamera *camera, unsigned int capacity = 2048);
+    ~SpriteBatch();
+
+    // Queue a sprite, taking the same arguments as SpriteRenderer::render
+    void render(Texture texture, Transform transform, glm::vec4 colour = glm::vec4(1.0f), int focus = 0);
+
+    // Draw every queued sprite
+    void flush();
+
+  private:
+    Shader shader;
+    OrthoCamera *camera;
+    unsigned int vao, ebo;
+
+    // The number of sprites drawn per draw call at most, and the textures of the sprites queued so far
+    unsigned int capacity;
+    unsigned int texture, frames;
+    std::vector<SpriteVertex> vertices;
+};
+
+// Draws a set of sprites which rarely change from a vertex buffer kept on the GPU.
+// The sprites are sorted by texture, so the whole layer takes a single draw call per texture. Drawing the layer
+// again costs no CPU work besides those draw calls, and changing a sprite only uploads the vertices of that sprite.
+class SpriteLayer {
+  public:
+    SpriteLayer(Shader &shader, OrthoCamera *camera);
+    ~SpriteLayer();
+
+    // Replace every sprite in the layer
+    void rebuild(const std::vector<Sprite> &sprites);
+
+    // Patch a single sprite in place. This fails if the layer has no sprite with the same key, or if the texture of
+    // the sprite changed (which would move it into another draw call), in which case the layer has to be rebuilt.
+    bool update(const Sprite &sprite);
+
+    // Draw every sprite in the layer. Flush any batch drawn underneath the layer first.
+    void render();
+
+  private:
+    // A range of sprites sharing a texture
+    typedef struct Run {
+      unsigned int target, texture;
+      unsigned int first, count;
+    } Run;
+
+    Shader shader;
+    OrthoCamera *camera;
+    unsigned int vao, vbo, ebo;
+
+    // The number of sprites the buffers were last allocated for
+    unsigned int capacity;
+
+    // Where each sprite lives in the buffer, and the texture it was drawn with
+    std::map<unsigned long, unsigned int> slots;
+    std::vector<unsigned int> textures;
+    std::vector<Run> runs;
+
+    // The pixels each sprite covers on the screen, and their sum (see RenderStats::fill)
+    std::vector<unsigned long> fills;
+    unsigned long fill;
+};
+
 #endif
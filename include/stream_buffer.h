@@ -0,0 +1,44 @@
+#ifndef __STREAM_BUFFER_H__
+#define __STREAM_BUFFER_H__
+
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <stdexcept>
+
+#include "glad/gl.h"
+
+#include "gl_state.h"
+#include "render_stats.h"
+
+// This namespace owns the single vertex buffer that every piece of geometry rebuilt each frame is streamed through
+// (the sprite batch, the debug shapes, the preview path and text). The buffer is a ring split into regions, which are filled
+// one after the other. When ARB_buffer_storage is available the whole ring stays mapped, vertices are copied straight
+// into it, and a fence is placed behind each region once it is full (at the end of the frame that filled it), so it is
+// only written over after the GPU has drawn from it. Otherwise the vertices are uploaded with glBufferSubData, and the storage is orphaned every time the
+// ring wraps around. Either way no upload ever has to wait for a draw call reading an earlier part of the buffer.
+namespace StreamBuffer {
+  // The number of regions in the ring, and the size of each of them in bytes
+  const unsigned int REGIONS = 3;
+  const unsigned int REGION_SIZE = 4 << 20;
+
+  // Whether the ring is persistently mapped. Setting this to false before init forces the orphaning fallback, and
+  // init turns it off if the context does not support ARB_buffer_storage.
+  extern bool persistent;
+
+  // Create the buffer, and delete it again
+  void init();
+  void destroy();
+
+  // The name of the buffer, for the vertex arrays to source their vertices from
+  unsigned int id();
+
+  // Copy vertices of the given stride into the ring, and return the index of the first of them, to draw them with.
+  // A single write can be at most a region (minus a vertex) in size. Leaves the buffer bound to GL_ARRAY_BUFFER.
+  unsigned int write(const void *data, unsigned int size, unsigned int stride);
+
+  // Fence the regions filled during the frame, right before the frame is swapped onto the screen
+  void end_frame();
+}
+
+#endif
@@ -3,15 +3,27 @@
 
 #include "glad/gl.h"
 #include "stb/stb_image.h"
+#include "glm/glm.hpp"
+
+#include "gl_state.h"
 
 class Texture {
   public:
-    // Holds the ID of the texture, which is how it will be referenced in the future
+    // Holds the ID of the texture, which is how it will be referenced in the future. It stays 0 until the texture is generated.
     unsigned int id;
 
     // Holds the dimensions of the texture
     unsigned int width, height;
 
+    // The region of the GL texture holding the image, as the (x, y) of its top-left corner and its (width, height) in
+    // texture coordinates. Textures packed into an atlas share the GL texture of the atlas, and only cover part of it.
+    glm::vec4 uv;
+
+    // The frames of an animation are uploaded as the layers of a single GL_TEXTURE_2D_ARRAY.
+    // Such a texture has GL_TEXTURE_2D_ARRAY as its target, and the layer holding its frame.
+    unsigned int target;
+    unsigned int layer;
+
     // Sets the pixel formatting for the texture
     unsigned int texture_format, image_format;
 
@@ -27,8 +39,11 @@ class Texture {
     // Generate the texture given image width, height, and pixel data
     void generate(unsigned int width, unsigned int height, unsigned char *data);
 
-    // Binds the texture as current active GL_TEXTURE_2D texture object
-    void bind() const;
+    // Generate an array texture given the size of each layer, the number of layers, and the pixel data of every layer one after another
+    void generate(unsigned int width, unsigned int height, unsigned int layers, unsigned char *data);
+
+    // Binds the texture to its target on the given texture unit
+    void bind(unsigned int unit = 0) const;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,43 @@
+#ifndef __TRIPLE_BUFFER_H__
+#define __TRIPLE_BUFFER_H__
+
+#include <atomic>
+
+// A lock-free triple buffer to hand complete states from a single producer to a single consumer.
+// The producer always owns the back buffer and the consumer always owns the front buffer, while
+// the third buffer sits in the middle holding the latest published state. Neither side ever waits
+// for the other, and the consumer always sees the most recent state that was fully written.
+template <typename T>
+class TripleBuffer {
+  public:
+    // Fetch the buffer the producer is allowed to write into
+    T &back() { return this->buffers[this->back_index]; }
+
+    // Fetch the buffer the consumer is allowed to read from
+    T &front() { return this->buffers[this->front_index]; }
+
+    // Publish the back buffer, handing the producer the previous middle buffer to write into next
+    void publish() {
+      this->back_index = this->middle.exchange(this->back_index | FRESH, std::memory_order_acq_rel) & INDEX;
+    }
+
+    // Swap the front buffer with the middle one if a new state has been published since the last call.
+    // Returns true if the front buffer now holds a new state.
+    bool acquire() {
+      if (!(this->middle.load(std::memory_order_acquire) & FRESH)) return false;
+      this->front_index = this->middle.exchange(this->front_index, std::memory_order_acq_rel) & INDEX;
+      return true;
+    }
+
+  private:
+    // The middle index is tagged with this bit whenever it holds a state the consumer has not seen yet
+    static const int FRESH = 4;
+    static const int INDEX = 3;
+
+    T buffers[3];
+    int back_index = 0;
+    int front_index = 1;
+    std::atomic<int> middle { 2 };
+};
+
+#endif
@@ -9,6 +9,9 @@
 // Declare commonly used global variables
 extern glm::vec2 WindowSize;
 
+// The dimensions of the current level, which may be larger than what the camera can see
+extern glm::vec2 WorldSize;
+
 // Struct holding the transformations to be applied to the object
 typedef struct Transform {
   // Declare the constructors for a transform
@@ -24,7 +27,8 @@ typedef struct Transform {
 };
 
 namespace Time {
-  extern double delta;
+  // The frame time which has not been consumed by fixed physics ticks yet
+  extern double accumulator;
 }
 
 // Convert the screen coordinates to the world coordinates
@@ -0,0 +1,71 @@
+#include "cached_layer.h"
+
+CachedLayer::CachedLayer(OrthoCamera *camera, unsigned int width, unsigned int height) {
+  this->camera = camera;
+  this->redraws = 0;
+
+  // The texture is flipped vertically, as the camera's projection puts the top of the screen at the top of the framebuffer
+  this->texture.texture_format = GL_RGBA;
+  this->texture.image_format = GL_RGBA;
+  this->texture.uv = glm::vec4(0.0f, 1.0f, 1.0f, -1.0f);
+
+  glGenFramebuffers(1, &this->fbo);
+  this->resize(width, height);
+}
+
+CachedLayer::~CachedLayer() {
+  GLState::forget_framebuffer(this->fbo);
+  GLState::forget_texture(this->texture.id);
+  glDeleteFramebuffers(1, &this->fbo);
+  glDeleteTextures(1, &this->texture.id);
+}
+
+void CachedLayer::resize(unsigned int width, unsigned int height) {
+  this->texture.width = width;
+  this->texture.height = height;
+  this->dirty = true;
+  this->changed = false;
+
+  // Sample the texture pixel for pixel, without any mipmaps
+  if (this->texture.id == 0) glGenTextures(1, &this->texture.id);
+  GLState::edit_texture(GL_TEXTURE_2D, this->texture.id);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+  GLState::bind_framebuffer(this->fbo);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, this->texture.id, 0);
+  if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) printf("[ERROR] The framebuffer of a cached layer is incomplete\n");
+  GLState::bind_framebuffer(0);
+}
+
+void CachedLayer::render(SpriteBatch *batch, const std::function<void()> &draw) {
+  if (this->changed) {
+    draw();
+    this->changed = false;
+    return;
+  }
+
+  batch->flush();
+
+  // Draw the layer onto a transparent texture, finishing anything it queued in the batch before leaving the framebuffer
+  if (this->dirty) {
+    GLState::bind_framebuffer(this->fbo);
+    const float transparent[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    glClearBufferfv(GL_COLOR, 0, transparent);
+    draw();
+    batch->flush();
+    GLState::bind_framebuffer(0);
+
+    this->dirty = false;
+    this->redraws++;
+  }
+
+  // The colours of the texture are already multiplied by their alpha
+  GLState::blend(true, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+  batch->render(this->texture, Transform(glm::vec3(0.0f), glm::vec2(this->camera->width, this->camera->height)));
+  batch->flush();
+  GLState::blend(true);
+}
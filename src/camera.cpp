@@ -11,10 +11,35 @@ Camera::Camera(unsigned int width, unsigned int height, float near_plane, float
 
 void Camera::scale(float x, float y) {
   this->view_matrix = glm::scale(this->view_matrix, glm::vec3(x, y, 0.0f));
+  this->upload();
 }
 
 void Camera::scale(glm::vec2 factor) {
   this->view_matrix = glm::scale(this->view_matrix, glm::vec3(factor, 0.0f));
+  this->upload();
+}
+
+void Camera::bind() {
+  if (this->ubo == 0) {
+    glGenBuffers(1, &this->ubo);
+    GLState::bind_buffer(GL_UNIFORM_BUFFER, this->ubo);
+    glBufferData(GL_UNIFORM_BUFFER, 2 * sizeof(glm::mat4), nullptr, GL_DYNAMIC_DRAW);
+    GLState::bind_buffer(GL_UNIFORM_BUFFER, 0);
+  }
+
+  this->upload();
+  glBindBufferBase(GL_UNIFORM_BUFFER, UniformBlocks::CAMERA, this->ubo);
+}
+
+void Camera::upload() {
+  if (this->ubo == 0) return;
+
+  // The block is laid out with std140, where a mat4 is four vec4 columns, exactly like glm stores it
+  GLState::bind_buffer(GL_UNIFORM_BUFFER, this->ubo);
+  glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(glm::mat4), glm::value_ptr(this->projection_matrix));
+  glBufferSubData(GL_UNIFORM_BUFFER, sizeof(glm::mat4), sizeof(glm::mat4), glm::value_ptr(this->view_matrix));
+  GLState::bind_buffer(GL_UNIFORM_BUFFER, 0);
+  RenderStats::uniform_uploads++;
 }
 
 OrthoCamera::OrthoCamera(unsigned int width, unsigned int height, float near_plane, float far_plane)
@@ -30,6 +55,7 @@ void OrthoCamera::resize(unsigned int width, unsigned int height) {
   this->width = width;
   this->height = height;
   this->projection_matrix = glm::ortho(0.0f, (float)width, (float)height, 0.0f, this->near, this->far);
+  this->upload();
 }
 
 
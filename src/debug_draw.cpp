@@ -0,0 +1,104 @@
+#include "debug_draw.h"
+
+// A label waiting for the flush
+typedef struct Label {
+  std::string text;
+  glm::vec2 position;
+  glm::vec4 colour;
+  float scale;
+} Label;
+
+// The quads and labels of the frame so far
+static std::vector<SpriteVertex> vertices;
+static std::vector<Label> labels;
+
+// The vertex array and index buffer the quads are drawn with, created the first time anything is drawn
+static unsigned int debug_vao = 0, debug_ebo = 0;
+
+// Add a quad from its four corners, in the order sprite_quad gives them. The texture coordinates are filled in by
+// the flush, and the local coordinates keep the quad away from the border highlight of the batch shader.
+static void quad(glm::vec2 a, glm::vec2 b, glm::vec2 c, glm::vec2 d, glm::vec4 colour) {
+  for (glm::vec2 corner : { a, b, c, d })
+    vertices.push_back({ corner, glm::vec2(0.0f), glm::vec2(0.5f), colour, 0.0f, -1.0f });
+}
+
+void DebugDraw::rect(glm::vec2 position, glm::vec2 size, glm::vec4 colour) {
+  quad(position, position + glm::vec2(0.0f, size.y), position + size, position + glm::vec2(size.x, 0.0f), colour);
+}
+
+void DebugDraw::line(glm::vec2 from, glm::vec2 to, glm::vec4 colour, float width) {
+  glm::vec2 direction = to - from;
+  float length = glm::length(direction);
+  if (length == 0.0f) return;
+
+  // Widen the line into a quad along its normal
+  glm::vec2 normal = glm::vec2(-direction.y, direction.x) / length * (width / 2.0f);
+  quad(from - normal, from + normal, to + normal, to - normal, colour);
+}
+
+void DebugDraw::box(BoundingBox box, glm::vec4 colour, float width) {
+  float w = box.right - box.left, h = box.bottom - box.top;
+  width = std::fmin(width, std::fmin(w, h) / 2.0f);
+
+  // Four strips which do not overlap, so translucent outlines have even corners
+  DebugDraw::rect(glm::vec2(box.left, box.top), glm::vec2(w, width), colour);
+  DebugDraw::rect(glm::vec2(box.left, box.bottom - width), glm::vec2(w, width), colour);
+  DebugDraw::rect(glm::vec2(box.left, box.top + width), glm::vec2(width, h - width * 2.0f), colour);
+  DebugDraw::rect(glm::vec2(box.right - width, box.top + width), glm::vec2(width, h - width * 2.0f), colour);
+}
+
+void DebugDraw::point(glm::vec2 position, glm::vec4 colour, float size) {
+  DebugDraw::rect(position - glm::vec2(size / 2.0f), glm::vec2(size), colour);
+}
+
+void DebugDraw::label(const std::string &text, glm::vec2 position, glm::vec4 colour, float scale) {
+  labels.push_back({ text, position, colour, scale });
+}
+
+void DebugDraw::flush() {
+  if (!vertices.empty()) {
+    unsigned int count = vertices.size() / 4;
+
+    // Every quad is a flat colour, sampled from the middle of the blank texture
+    Texture blank = ResourceManager::Texture::get("blank");
+    glm::vec2 uv = glm::vec2(blank.uv) + glm::vec2(blank.uv.z, blank.uv.w) / 2.0f;
+    float layer = (blank.target == GL_TEXTURE_2D_ARRAY) ? (float)blank.layer : -1.0f;
+    for (SpriteVertex &vertex : vertices) {
+      vertex.texture_coordinate = uv;
+      vertex.layer = layer;
+    }
+
+    if (debug_vao == 0) {
+      glGenVertexArrays(1, &debug_vao);
+      glGenBuffers(1, &debug_ebo);
+      GLState::bind_vertex_array(debug_vao);
+      GLState::bind_buffer(GL_ARRAY_BUFFER, StreamBuffer::id());
+
+      std::vector<unsigned int> indices = sprite_indices(DebugDraw::CHUNK);
+      GLState::bind_buffer(GL_ELEMENT_ARRAY_BUFFER, debug_ebo);
+      glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * indices.size(), indices.data(), GL_STATIC_DRAW);
+      sprite_attributes();
+    }
+
+    Shader shader = ResourceManager::Shader::get("batch");
+    shader.activate();
+    shader.set_integer(Uniforms::SPRITE, 0);
+    shader.set_integer(Uniforms::FRAMES, 1);
+    GLState::bind_texture(blank.target == GL_TEXTURE_2D_ARRAY ? 1 : 0, blank.target, blank.id);
+
+    // Stream the quads in chunks that fit into a region of the stream buffer, which is a single chunk unless the
+    // frame is crowded with shapes
+    for (unsigned int chunk = 0; chunk < count; chunk += DebugDraw::CHUNK) {
+      unsigned int quads = std::min(count - chunk, DebugDraw::CHUNK);
+      unsigned int first = StreamBuffer::write(&vertices[chunk * 4], sizeof(SpriteVertex) * quads * 4, sizeof(SpriteVertex));
+      GLState::bind_vertex_array(debug_vao);
+      glDrawElementsBaseVertex(GL_TRIANGLES, quads * 6, GL_UNSIGNED_INT, 0, first);
+      RenderStats::draw_calls++;
+    }
+    vertices.clear();
+  }
+
+  for (const Label &label : labels)
+    Text::render(label.text, "monocraft", Transform(glm::vec3(label.position, 0.0f), glm::vec2(label.scale)), TEXT_BASELINE, label.colour);
+  labels.clear();
+}
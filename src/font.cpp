@@ -5,89 +5,153 @@ std::map<std::string, std::map<char, Character>> CharacterLookup;
 Shader TextShader;
 OrthoCamera *TextCamera = nullptr;
 
+// A string laid out once, with the quads of its glyphs relative to the start of its baseline. Drawing it again only
+// streams those quads and moves them into place through the model matrix.
+typedef struct Layout {
+  // What was laid out, to tell strings apart when their hashes collide
+  uint64_t hash;
+  std::string font, str;
+  glm::vec2 scale;
+
+  std::vector<float> vertices;
+  unsigned int texture;
+  unsigned int count;
+
+  // The width of the string and the height of its tallest glyph above the baseline, used to align it
+  float width, ascent;
+
+  // The corners of the area the quads cover, relative to the start of the baseline, used to cull the string
+  glm::vec2 min, max;
+} Layout;
+
+// The cached layouts from the most to the least recently drawn, and where the layout of each hash sits in that list
+static std::list<Layout> layouts;
+static std::unordered_map<uint64_t, std::list<Layout>::iterator> layout_lookup;
+
+// The vertex array drawing the quads of a layout from the stream buffer
+static unsigned int text_vao = 0;
+
 void Fonts::init(FT_Library &ft) {
   if (FT_Init_FreeType(&ft)) {
     printf("[ERROR] Freetype could not be initialised!\n");
   }
 }
 
+// Hash a font, scale and string together, without building a key out of them
+static uint64_t layout_hash(const char *font, glm::vec2 scale, const std::string &str) {
+  uint64_t hash = std::hash<std::string_view>()(std::string_view(str));
+  hash = hash * 31 + std::hash<std::string_view>()(std::string_view(font));
+  hash = hash * 31 + std::hash<float>()(scale.x);
+  hash = hash * 31 + std::hash<float>()(scale.y);
+  return hash;
+}
+
+// Lay a string out from scratch
+static Layout lay_out(const std::string &str, const char *font, glm::vec2 scale) {
+  Layout layout;
+  layout.font = font;
+  layout.str = str;
+  layout.scale = scale;
+  layout.texture = 0;
+  layout.width = 0.0f;
+  layout.ascent = 0.0f;
+  layout.min = glm::vec2(0.0f);
+  layout.max = glm::vec2(0.0f);
+
+  // Build the quads of every glyph, skipping the ones without any pixels (like spaces)
+  std::map<char, Character> &glyphs = CharacterLookup[font];
+  std::vector<float> &vertices = layout.vertices;
+  for (char c : str) {
+    Character &ch = glyphs[c];
+
+    // The distance field of each glyph reaches past the glyph by the spread, so its quad does too
+    float xpos = layout.width + (ch.bearing.x - Fonts::SDF_SPREAD) * scale.x;
+    float ypos = -(ch.bearing.y + Fonts::SDF_SPREAD) * scale.y;
+
+    float w = (ch.size.x + Fonts::SDF_SPREAD * 2) * scale.x;
+    float h = (ch.size.y + Fonts::SDF_SPREAD * 2) * scale.y;
+
+    if (ch.size.x > 0 && ch.size.y > 0) {
+      float u = ch.uv.x, v = ch.uv.y, u2 = ch.uv.x + ch.uv.z, v2 = ch.uv.y + ch.uv.w;
+      vertices.insert(vertices.end(), {
+        xpos,     ypos + h,   u,  v2,
+        xpos,     ypos,       u,  v,
+        xpos + w, ypos,       u2, v,
+
+        xpos,     ypos + h,   u,  v2,
+        xpos + w, ypos,       u2, v,
+        xpos + w, ypos + h,   u2, v2
+      });
+      layout.texture = ch.texture_id;
+      layout.min = glm::min(layout.min, glm::vec2(xpos, ypos));
+      layout.max = glm::max(layout.max, glm::vec2(xpos + w, ypos + h));
+    }
+    layout.ascent = std::fmax(layout.ascent, ch.bearing.y * scale.y);
+
+    // Advance the "cursor" to the correct offset for the next glyph
+    // Note: The offset, or advance, is in a number of 1/64 pixels, so bit-shifting by 6 will convert this value into a pixel size (2^6 = 64)
+    layout.width += (ch.advance >> 6) * scale.x;
+  }
+  layout.count = vertices.size() / 4;
+
+  return layout;
+}
+
 void Text::render(std::string str, const char *font, Transform transform, short alignment, glm::vec4 colour) {
   if (TextCamera == nullptr) throw std::runtime_error("[ERROR] TextCamera is undefined!");
 
-  unsigned int t_vao, t_vbo;
-  glGenVertexArrays(1, &t_vao);
-  glGenBuffers(1, &t_vbo);
-  glBindVertexArray(t_vao);
-  glBindBuffer(GL_ARRAY_BUFFER, t_vbo);
-  glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 6 * 4, nullptr, GL_DYNAMIC_DRAW);
-  glEnableVertexAttribArray(0);
-  glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), 0);
-  glBindBuffer(GL_ARRAY_BUFFER, 0);
-  glBindVertexArray(0);
+  // Find the layout of the string, moving it to the front of the cache, or lay it out and evict the least recently
+  // drawn layout once the cache is full. A different string with the same hash is evicted in its place.
+  glm::vec2 scale = glm::vec2(transform.scale);
+  uint64_t hash = layout_hash(font, scale, str);
+  std::unordered_map<uint64_t, std::list<Layout>::iterator>::iterator found = layout_lookup.find(hash);
+  if (found != layout_lookup.end() && (found->second->str != str || found->second->font != font || found->second->scale != scale)) {
+    layouts.erase(found->second);
+    layout_lookup.erase(found);
+    found = layout_lookup.end();
+  }
+
+  if (found != layout_lookup.end()) {
+    layouts.splice(layouts.begin(), layouts, found->second);
+  } else {
+    if (layouts.size() >= Text::LAYOUT_CACHE) {
+      layout_lookup.erase(layouts.back().hash);
+      layouts.pop_back();
+    }
+
+    layouts.push_front(lay_out(str, font, scale));
+    layouts.front().hash = hash;
+    layout_lookup[hash] = layouts.begin();
+  }
+  Layout &layout = layouts.front();
+  if (layout.count == 0) return;
 
+  // Align the start of the baseline from the bounds of the layout, so the same layout serves every alignment
   switch (alignment) {
     case TEXT_TOP_LEFT: {
-      transform.position += glm::vec3(0.0f);
-
-      float best_y = 0.0f;
-      for (std::string::const_iterator c = str.begin(); c != str.end(); c++) {
-        best_y = std::fmax(best_y, CharacterLookup[font][*c].bearing.y * transform.scale.y);
-      }
-      transform.position.y = best_y;
+      transform.position.y = layout.ascent;
       break;
     }
     case TEXT_TOP_CENTER: {
-      transform.position += glm::vec3(TextCamera->width / 2.0f, 0.0f, 0.0f);
-
-      float best_y = 0.0f;
-      for (std::string::const_iterator c = str.begin(); c != str.end(); c++) {
-        transform.position.x -= ((CharacterLookup[font][*c].advance >> 6) * transform.scale.x) / 2.0f;
-        best_y = std::fmax(best_y, CharacterLookup[font][*c].bearing.y * transform.scale.y);
-      }
-      transform.position.y = best_y;
+      transform.position += glm::vec3(TextCamera->width / 2.0f - layout.width / 2.0f, 0.0f, 0.0f);
+      transform.position.y = layout.ascent;
       break;
     }
     case TEXT_TOP_RIGHT: {
-      transform.position += glm::vec3((float)(TextCamera->width), 0.0f, 0.0f);
-
-      float best_y = 0.0f;
-      for (std::string::const_iterator c = str.begin(); c != str.end(); c++) {
-        transform.position.x -= (CharacterLookup[font][*c].advance >> 6) * transform.scale.x;
-        best_y = std::fmax(best_y, CharacterLookup[font][*c].bearing.y * transform.scale.y);
-      }
-      transform.position.y = best_y;
+      transform.position += glm::vec3((float)(TextCamera->width) - layout.width, 0.0f, 0.0f);
+      transform.position.y = layout.ascent;
       break;
     }
     case TEXT_MIDDLE_LEFT: {
-      transform.position += glm::vec3(0.0f, TextCamera->height / 2.0f, 0.0f);
-
-      float best_y = 0.0f;
-      for (std::string::const_iterator c = str.begin(); c != str.end(); c++) {
-        best_y = std::fmax(best_y, CharacterLookup[font][*c].bearing.y * transform.scale.y);
-      }
-      transform.position.y += best_y / 2.0f;
+      transform.position += glm::vec3(0.0f, TextCamera->height / 2.0f + layout.ascent / 2.0f, 0.0f);
       break;
     }
     case TEXT_MIDDLE_CENTER: {
-      transform.position += glm::vec3(TextCamera->width / 2.0f, TextCamera->height / 2.0f, 0.0f);
-
-      float best_y = 0.0f;
-      for (std::string::const_iterator c = str.begin(); c != str.end(); c++) {
-        transform.position.x -= ((CharacterLookup[font][*c].advance >> 6) * transform.scale.x) / 2.0f;
-        best_y = std::fmax(best_y, CharacterLookup[font][*c].bearing.y * transform.scale.y);
-      }
-      transform.position.y += best_y / 2.0f;
+      transform.position += glm::vec3(TextCamera->width / 2.0f - layout.width / 2.0f, TextCamera->height / 2.0f + layout.ascent / 2.0f, 0.0f);
       break;
     }
     case TEXT_MIDDLE_RIGHT: {
-      transform.position += glm::vec3(TextCamera->width, TextCamera->height / 2.0f, 0.0f);
-
-      float best_y = 0.0f;
-      for (std::string::const_iterator c = str.begin(); c != str.end(); c++) {
-        transform.position.x -= (CharacterLookup[font][*c].advance >> 6) * transform.scale.x;
-        best_y = std::fmax(best_y, CharacterLookup[font][*c].bearing.y * transform.scale.y);
-      }
-      transform.position.y += best_y / 2.0f;
+      transform.position += glm::vec3(TextCamera->width - layout.width, TextCamera->height / 2.0f + layout.ascent / 2.0f, 0.0f);
       break;
     }
     case TEXT_BOTTOM_LEFT: {
@@ -95,18 +159,14 @@ void Text::render(std::string str, const char *font, Transform transform, short
       break;
     }
     case TEXT_BOTTOM_CENTER: {
-      transform.position += glm::vec3(TextCamera->width / 2.0f, TextCamera->height, 0.0f);
-      for (std::string::const_iterator c = str.begin(); c != str.end(); c++) {
-        transform.position.x -= ((CharacterLookup[font][*c].advance >> 6) * transform.scale.x) / 2.0f;
-      }
+      transform.position += glm::vec3(TextCamera->width / 2.0f - layout.width / 2.0f, TextCamera->height, 0.0f);
       break;
     }
     case TEXT_BOTTOM_RIGHT: {
-      transform.position += glm::vec3(TextCamera->width, TextCamera->height, 0.0f);
-
-      for (std::string::const_iterator c = str.begin(); c != str.end(); c++) {
-        transform.position.x -= ((CharacterLookup[font][*c].advance >> 6) * transform.scale.x);
-      }
+      transform.position += glm::vec3(TextCamera->width - layout.width, TextCamera->height, 0.0f);
+      break;
+    }
+    case TEXT_BASELINE: {
       break;
     }
     default: {
@@ -115,53 +175,32 @@ void Text::render(std::string str, const char *font, Transform transform, short
     }
   }
 
-  // Activate corresponding rendering shader	
-  TextShader.activate();
-  TextShader.set_vector_4f("text_colour", colour);
-  TextShader.set_matrix_4f("projection", TextCamera->projection_matrix);
-  glActiveTexture(GL_TEXTURE0);
-  glBindVertexArray(t_vao);
-
-  // Iterate through all the characters within the string
-  std::string::const_iterator c;
-  for (c = str.begin(); c != str.end(); c++) {
-    Character ch = CharacterLookup[font][*c];
-
-    float xpos = transform.position.x + ch.bearing.x * transform.scale.x;
-    float ypos = transform.position.y - ch.bearing.y * transform.scale.y;
-
-    float w = ch.size.x * transform.scale.x;
-    float h = ch.size.y * transform.scale.y;
-
-    // Create unique VBOs for each glyph with correct offset and scale
-    // Not using EBOs because it's too much effort
-    float vertices[6][4] = {
-      { xpos,     ypos + h,   0.0f, 1.0f },            
-      { xpos,     ypos,       0.0f, 0.0f },
-      { xpos + w, ypos,       1.0f, 0.0f },
-
-      { xpos,     ypos + h,   0.0f, 1.0f },
-      { xpos + w, ypos,       1.0f, 0.0f },
-      { xpos + w, ypos + h,   1.0f, 1.0f }           
-    };
-
-    // Render the glyph texture over the quad we just made
-    glBindTexture(GL_TEXTURE_2D, ch.texture_id);
-
-    // Update the content of the VBO buffer
-    glBindBuffer(GL_ARRAY_BUFFER, t_vbo);
-    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices); 
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-    // Draw the buffer onto the screen
-    glDrawArrays(GL_TRIANGLES, 0, 6);
-
-    // Advance the "cursor" to the correct offset for the next glyph
-    // Note: The offset, or advance, is in a number of 1/64 pixels, so bit-shifting by 6 will convert this value into a pixel size (2^6 = 64)
-    transform.position.x += (ch.advance >> 6) * transform.scale.x;
+  // Skip strings that lie entirely off the screen, like labels of objects outside of the camera
+  glm::vec2 min = glm::vec2(transform.position) + layout.min, max = glm::vec2(transform.position) + layout.max;
+  if (max.x < 0.0f || min.x > TextCamera->width || max.y < 0.0f || min.y > TextCamera->height) {
+    RenderStats::culled++;
+    return;
+  }
+  RenderStats::visible++;
+
+  if (text_vao == 0) {
+    glGenVertexArrays(1, &text_vao);
+    GLState::bind_vertex_array(text_vao);
+    GLState::bind_buffer(GL_ARRAY_BUFFER, StreamBuffer::id());
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), 0);
+    GLState::bind_buffer(GL_ARRAY_BUFFER, 0);
+    GLState::bind_vertex_array(0);
   }
 
-  // Unbind the VAOs and the textures
-  glBindVertexArray(0);
-  glBindTexture(GL_TEXTURE_2D, 0);
+  unsigned int first = StreamBuffer::write(layout.vertices.data(), sizeof(float) * layout.vertices.size(), sizeof(float) * 4);
+
+  // Activate corresponding rendering shader, and draw the whole string at once
+  TextShader.activate();
+  TextShader.set_matrix_4f(Uniforms::MODEL, glm::translate(glm::mat4(1.0f), glm::vec3(transform.position.x, transform.position.y, 0.0f)));
+  TextShader.set_vector_4f(Uniforms::TEXT_COLOUR, colour);
+  GLState::bind_texture(0, GL_TEXTURE_2D, layout.texture);
+  GLState::bind_vertex_array(text_vao);
+  glDrawArrays(GL_TRIANGLES, first, layout.count);
+  RenderStats::draw_calls++;
 }
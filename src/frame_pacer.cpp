@@ -0,0 +1,62 @@
+#include "frame_pacer.h"
+
+VsyncMode FramePacer::vsync = VSYNC_ON;
+double FramePacer::fps_cap = 0.0;
+bool FramePacer::uncapped = false;
+bool FramePacer::report = false;
+
+// When the next frame is due
+static std::chrono::steady_clock::time_point next_frame = std::chrono::steady_clock::now();
+
+// The frames, wall-clock time and CPU time since the last report
+static unsigned int report_frames = 0;
+static std::chrono::steady_clock::time_point report_start = std::chrono::steady_clock::now();
+static std::clock_t report_cpu = std::clock();
+
+void FramePacer::init() {
+  int interval = 1;
+  if (FramePacer::uncapped || FramePacer::vsync == VSYNC_OFF) interval = 0;
+  else if (FramePacer::vsync == VSYNC_ADAPTIVE) {
+    // A negative interval asks for adaptive vsync, which needs the swap control tear extension
+    if (glfwExtensionSupported("WGL_EXT_swap_control_tear") || glfwExtensionSupported("GLX_EXT_swap_control_tear")) interval = -1;
+    else printf("[WARNING] Adaptive vsync is not supported, using regular vsync instead\n");
+  }
+  glfwSwapInterval(interval);
+
+  next_frame = std::chrono::steady_clock::now();
+}
+
+void FramePacer::wait(GLFWwindow *window) {
+  // The process's CPU time covers every thread, including the simulation and any the driver runs
+  if (FramePacer::report) {
+    report_frames++;
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - report_start).count();
+    if (elapsed >= 1.0) {
+      double cpu = (double)(std::clock() - report_cpu) / CLOCKS_PER_SEC;
+      printf("[PACING] %6.1f fps, %5.1f%% CPU\n", report_frames / elapsed, cpu * 100.0 / elapsed);
+      report_frames = 0;
+      report_start = std::chrono::steady_clock::now();
+      report_cpu = std::clock();
+    }
+  }
+
+  if (FramePacer::uncapped) return;
+
+  double fps = FramePacer::fps_cap;
+  if (glfwGetWindowAttrib(window, GLFW_ICONIFIED)) fps = MINIMISED_FPS;
+  else if (!glfwGetWindowAttrib(window, GLFW_FOCUSED)) fps = (fps > 0.0) ? std::min(fps, UNFOCUSED_FPS) : UNFOCUSED_FPS;
+  if (fps <= 0.0) return;
+
+  // Schedule frames a fixed period apart, rather than a period after the last one finished, so the rate does not
+  // drift. If the loop has fallen behind, start over from now rather than rushing through the frames it missed.
+  std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+  next_frame += std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / fps));
+  if (next_frame < now) {
+    next_frame = now;
+    return;
+  }
+
+  std::chrono::steady_clock::time_point wake = next_frame - std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(SPIN_SLICE));
+  if (wake > now) std::this_thread::sleep_until(wake);
+  while (std::chrono::steady_clock::now() < next_frame) std::this_thread::yield();
+}
@@ -2,6 +2,10 @@
 
 // Set up pointers to global objects for the game
 SpriteRenderer *Renderer;
+SpriteBatch *Batch;
+SpriteLayer *Tiles;
+CachedLayer *Backgrounds, *TileCache;
+RenderQueue *Queue;
 OrthoCamera *GameCamera;
 
 // Forward-declare the tile size constant
@@ -15,26 +19,32 @@ Game::Game(unsigned int width, unsigned int height, std::string window_title, bo
   this->GameTitle = window_title;
   this->fullscreen = fullscreen;
 
-  // Initialise GLFW
-  if (!glfwInit()) {
-    printf("[ERROR] GLFW failed to initialise!\n");
-  }
-
-  // Create a window for the game
+  // Without a window, render into a framebuffer of an offscreen context instead
   this->fullscreen = false;
-  set_window_hints();
-  create_window(this->GameWindow);
+  if (Headless::enabled) {
+    this->GameWindow = nullptr;
+    if (!Headless::init(width, height)) exit(-1);
+  } else {
+    // Initialise GLFW
+    if (!glfwInit()) {
+      printf("[ERROR] GLFW failed to initialise!\n");
+    }
+
+    // Create a window for the game
+    set_window_hints();
+    create_window(this->GameWindow);
 
-  // Initialise OpenGL using GLAD
-  gladLoadGL(glfwGetProcAddress);
+    // Initialise OpenGL using GLAD, and set up the vsync of its context
+    gladLoadGL(glfwGetProcAddress);
+    FramePacer::init();
+  }
 
   // Initialise the OpenGL viewport
   // In this case, the viewport goes from x=0 y=0 to x=width y=height (left to right, bottom to top)
   glViewport(0, 0, width, height);
 
   // Enable alpha and transparency in OpenGL
-  glEnable(GL_BLEND);
-  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  GLState::blend(true, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
   // Initialise the game
   this->init();
@@ -45,22 +55,24 @@ Game::~Game() {
   // Properly remove all the resources in resource manager's list
   ResourceManager::deallocate();
   delete Renderer;
+  delete Batch;
+  delete Tiles;
+  delete Backgrounds;
+  delete TileCache;
+  delete Queue;
+  StreamBuffer::destroy();
+  Jobs::shutdown();
 
   // Clean up and close the game
+  if (Headless::enabled) {
+    Headless::destroy();
+    return;
+  }
   glfwDestroyWindow(this->GameWindow);
   glfwTerminate();
 }
 
 void Game::load_level(const char *path) {
-  this->GameState = std::map<std::string, bool>();
-
-  Mouse.clicked_object = nullptr;
-  Mouse.focused_objects = std::vector<GameObject *>();
-
-  for (GameObject *&object : GameObjects::all()) {
-    GameObjects::uninstantiate(object->id);
-  }
-
   std::vector<std::vector<std::string>> instantiation_order;
   std::ifstream levelmap(path);
   std::string delimiter = ";";
@@ -89,6 +101,60 @@ void Game::load_level(const char *path) {
     }
   }
 
+  this->build_level(instantiation_order);
+}
+
+void Game::generate_level(unsigned int columns, unsigned int rows, unsigned int walkers, unsigned int seed) {
+  std::mt19937 random(seed);
+
+  // Fill the level with a random selection of tiles that walkers can safely bounce around in, with a goal at the very end
+  std::vector<std::string> tiles = { "tile-full", "tile-half", "tile-full-obstacle-safe-left", "tile-full-obstacle-safe-right", "tile-half-obstacle-safe-left" };
+  std::vector<std::vector<std::string>> instantiation_order;
+  for (unsigned int i = 0; i < rows; i++) {
+    std::vector<std::string> layer;
+    for (unsigned int j = 0; j < columns; j++) layer.push_back(tiles[random() % tiles.size()]);
+    instantiation_order.push_back(layer);
+  }
+  instantiation_order.back().back() = "tile-full-goal-centered";
+
+  this->build_level(instantiation_order);
+
+  // Drop the walkers in at random positions across the level
+  Player *player = Characters::Players::ActivePlayer;
+  for (unsigned int i = 0; i < walkers; i++) {
+    glm::vec3 position = glm::vec3(
+      (random() % columns) * TileSize.x + (random() % (int)(TileSize.x - player->transform.scale.x)),
+      (random() % rows) * TileSize.y + (random() % (int)(TileSize.y / 2.0f)),
+      1.0f
+    );
+
+    Player *walker = Characters::Players::create(("walker-" + std::to_string(i)).c_str(), player->texture, Transform(position, player->transform.scale), { "player", "walker" });
+    walker->fps = player->fps;
+    walker->texture_index = random() % walker->texture.size();
+    if (random() % 2) {
+      walker->walk_speed *= -1.0f;
+      walker->flip_x = true;
+    }
+  }
+}
+
+void Game::build_level(std::vector<std::vector<std::string>> &instantiation_order) {
+  this->GameState = std::map<std::string, bool>();
+
+  Mouse.clicked_object = nullptr;
+  Mouse.focused_objects = std::vector<GameObject *>();
+  this->trajectory.clear();
+  this->tile_revision++;
+
+  // Remove the previous level, including any walkers, but keep the active player around
+  Characters::Players::clear();
+  for (GameObject *&object : GameObjects::except("player")) {
+    GameObjects::uninstantiate(object->id);
+  }
+
+  // The level may be larger than what the camera can see
+  WorldSize = glm::vec2(instantiation_order.size() ? instantiation_order.begin()->size() : 0, instantiation_order.size()) * TileSize;
+
   // Create GameObjects
   for (int i = 0; i < instantiation_order.size(); i++) {
     for (int j = 0; j < instantiation_order.begin()->size(); j++) {
@@ -103,6 +169,7 @@ void Game::load_level(const char *path) {
 
   if (Characters::Players::ActivePlayer != nullptr) {
     Characters::Players::ActivePlayer->parent = nullptr;
+    Characters::Players::ActivePlayer->contacts.clear();
     Characters::Players::ActivePlayer->translate(glm::vec3(100.0f, 450.0f, 0.0f));
     Characters::Players::ActivePlayer->flip_x = false;
     Characters::Players::ActivePlayer->velocity = glm::vec2(0.0f);
@@ -124,25 +191,37 @@ void Game::init() {
   // Create a shader program, providing the default vertex and fragment shaders
   Shader sprite_shader = ResourceManager::Shader::load("src/shaders/default.vert", "src/shaders/default.frag", "default");
   TextShader = ResourceManager::Shader::load("src/shaders/text.vert", "src/shaders/text.frag", "text");
+  Shader batch_shader = ResourceManager::Shader::load("src/shaders/batch.vert", "src/shaders/batch.frag", "batch");
+  Shader background_shader = ResourceManager::Shader::load("src/shaders/background.vert", "src/shaders/background.frag", "background");
 
   // Instantiate the camera and the renderer
   GameCamera = new OrthoCamera(this->width, this->height, -100.0f, 100.0f);
+  GameCamera->bind();
   TextCamera = GameCamera;
   WindowSize = glm::vec2(this->width, this->height);
   Renderer = new SpriteRenderer(sprite_shader, GameCamera);
+  StreamBuffer::init();
+  Batch = new SpriteBatch(batch_shader, GameCamera);
+  Tiles = new SpriteLayer(batch_shader, GameCamera);
+  Backgrounds = new CachedLayer(GameCamera, this->width, this->height);
+  TileCache = new CachedLayer(GameCamera, this->width, this->height);
+  Queue = new RenderQueue(Batch, batch_shader.id);
 
   // Initialise the font renderer
-  ResourceManager::Font::load("fonts/monocraft.ttf", "monocraft", 128, FILTER_NEAREST);
+  ResourceManager::Font::load("fonts/monocraft.ttf", "monocraft", 128);
   ResourceManager::Texture::load("textures/blank.png", true, "blank");
 
   // Assign the camera and the renderer as global renderers for the GameObject
   GameObjects::Camera = GameCamera;
   GameObjects::Renderer = Renderer;
+  GameObjects::Batch = Batch;
+  GameObjects::Queue = Queue;
 
   TileSize = glm::vec2(GameCamera->width / 3.0f, GameCamera->height / 2.0f);
 
   // Load the textures from a given R* file
   ResourceManager::Texture::load_from_file("required.textures");
+  Parallax::load_from_file("required.parallax", background_shader);
   
   // Create the player
   Player *player = Characters::Players::create("player", ResourceManager::Texture::get("blank"), Transform(glm::vec3(100.0f, 450.0f, 1.0f), glm::vec2(72.72f, 100.0f)), { "player" });
@@ -150,12 +229,12 @@ void Game::init() {
   player->fps = 150;
   // player->collider_revealed = true;
 
-  // Load the player's animation sprites
+  // Load the player's animation sprites as a single array texture
   std::string base_name = "run";
   std::string base_path = "textures/player/";
-  for (int i = 0; i < 5; i++) {
-    player->texture.push_back(ResourceManager::Texture::load((base_path + base_name + std::to_string(i) + ".png").c_str(), true, "player-" + base_name + "-" + std::to_string(i)));
-  }
+  std::vector<std::string> frame_paths;
+  for (int i = 0; i < 5; i++) frame_paths.push_back(base_path + base_name + std::to_string(i) + ".png");
+  player->texture = ResourceManager::Texture::load_frames(frame_paths, true, "player-" + base_name);
   
   Characters::Players::ActivePlayer = player;
 
@@ -184,18 +263,229 @@ std::string Game::cstate(std::string state) {
 }
 
 void Game::run() {
+  // In threaded mode, the simulation runs on its own thread and this thread only polls events and renders
+  if (this->threaded) {
+    this->publish();
+    this->simulating = true;
+    std::thread simulation(&Game::simulate, this);
+
+    while(!this->should_close()) {
+      if (!Headless::enabled) glfwPollEvents();
+
+      // Render the latest complete world state. If the simulation has not published a new
+      // one since the last frame, the previous state is simply rendered again.
+      this->WorldStates.acquire();
+      this->render(this->view(this->WorldStates.front()));
+      this->handle_window_requests();
+      FramePacer::wait(this->GameWindow);
+    }
+
+    this->simulating = false;
+    simulation.join();
+    return;
+  }
+
   std::chrono::high_resolution_clock::time_point start_point, end_point;
-  while(!glfwWindowShouldClose(this->GameWindow)) {
-    Time::delta = std::chrono::duration_cast<std::chrono::milliseconds>(end_point - start_point).count() / 1000.0f;
+  while(!this->should_close()) {
+    // Headless frames each advance by a single tick, so the same run always renders the same frames
+    double delta = Headless::enabled ? Physics::TICK : std::chrono::duration<double>(end_point - start_point).count();
 
     start_point = std::chrono::high_resolution_clock::now();
-    this->update();
-    this->render();
+    if (!Headless::enabled) glfwPollEvents();
+    this->update(delta);
+    this->snapshot(this->LiveState);
+    this->render(this->view(this->LiveState));
+    this->handle_window_requests();
+    FramePacer::wait(this->GameWindow);
     end_point = std::chrono::high_resolution_clock::now();
   }
 }
 
-void Game::update() {
+bool Game::should_close() {
+  if (Headless::enabled) return Headless::done() || this->close_requested;
+  return glfwWindowShouldClose(this->GameWindow);
+}
+
+void Game::simulate() {
+  std::chrono::high_resolution_clock::time_point next_tick = std::chrono::high_resolution_clock::now();
+  const std::chrono::duration<double> tick(Physics::TICK);
+
+  while (this->simulating) {
+    // Each update covers exactly one tick, so the accumulator steps the physics once per update
+    {
+      std::lock_guard<std::mutex> lock(this->SimulationMutex);
+      this->update(Physics::TICK);
+      this->publish();
+    }
+
+    // Sleep until the next tick is due. If the simulation has fallen behind, skip the ticks
+    // it missed rather than trying to catch up all at once.
+    next_tick += std::chrono::duration_cast<std::chrono::high_resolution_clock::duration>(tick);
+    if (next_tick < std::chrono::high_resolution_clock::now()) next_tick = std::chrono::high_resolution_clock::now();
+    std::this_thread::sleep_until(next_tick);
+  }
+}
+
+void Game::snapshot(WorldState &state) {
+  // Snapshot every active object, reusing the memory of the state's previous snapshots
+  state.objects.clear();
+  for (GameObject *object : GameObjects::all()) state.objects.push_back(object->snapshot());
+
+  // Cull here, where the spatial index lives, and only hand the ids of the visible objects to the renderer
+  std::vector<GameObject *> visible;
+  this->cull(visible);
+  state.visible.clear();
+  for (GameObject *object : visible) state.visible.push_back(object->id);
+
+  state.focused_objects.clear();
+  for (GameObject *object : Mouse.focused_objects) state.focused_objects.push_back(object->id);
+
+  Player *player = Characters::Players::ActivePlayer;
+  state.clicked_object = (Mouse.clicked_object != nullptr) ? (long)Mouse.clicked_object->id : -1;
+  state.player_parent = (player->parent != nullptr) ? (long)player->parent->id : -1;
+  state.player = player->id;
+  state.player_died = player->die;
+  state.mouse_position = Mouse.position;
+  state.trajectory = this->trajectory;
+  state.tile_revision = this->tile_revision;
+  state.game_over = this->state("game-over");
+  state.lost = this->state("lost");
+  state.immovable_player = this->state("immovable-player");
+}
+
+void Game::publish() {
+  this->snapshot(this->WorldStates.back());
+  this->WorldStates.publish();
+}
+
+void Game::cull(std::vector<GameObject *> &visible) {
+  // Tiles, and everything on them, may have moved since the last tick indexed them
+  if (this->tile_revision != this->culled_tile_revision) {
+    GameObjects::index();
+    this->culled_tile_revision = this->tile_revision;
+  }
+
+  float width = GameObjects::Camera->width, height = GameObjects::Camera->height;
+  this->cull_candidates.clear();
+  GameObjects::query_sprites(BoundingBox(-CULL_MARGIN, height + CULL_MARGIN, -CULL_MARGIN, width + CULL_MARGIN), this->cull_candidates);
+  for (Player *player : Characters::Players::all()) this->cull_candidates.push_back(player);
+
+  for (GameObject *object : this->cull_candidates) {
+    if (!object->active) continue;
+
+    float z = object->transform.position.z;
+    if (z >= GameObjects::Camera->far || z <= GameObjects::Camera->near) {
+      if (this->depth_warned.insert(object->id).second) printf("[WARNING] Object (%lu) %s has z-index out of the camera's range\n", object->id, object->handle.c_str());
+      continue;
+    }
+
+    // Test the sprite itself, which may be flipped, rather than its collider
+    BoundingBox bounds = object->render_bounds();
+    if (bounds.right < 0.0f || bounds.left > width || bounds.bottom < 0.0f || bounds.top > height) continue;
+
+    visible.push_back(object);
+  }
+
+  std::sort(visible.begin(), visible.end(), [](GameObject *a, GameObject *b) { return a->id < b->id; });
+}
+
+Game::RenderView Game::view(WorldState &state) {
+  RenderView view;
+  std::vector<unsigned long>::iterator visible = state.visible.begin();
+  for (ObjectSnapshot &object : state.objects) {
+    view.objects.push_back(&object);
+
+    // Both the objects and the visible ids are sorted by id, so they can be walked through together
+    if (visible != state.visible.end() && *visible == object.id) {
+      view.visible.push_back(&object);
+      visible++;
+    }
+    if ((long)object.id == state.clicked_object) view.clicked_object = &object;
+    if ((long)object.id == state.player_parent) view.player_parent = &object;
+    if ((long)object.id == state.player) view.player = &object;
+    if (std::find(state.focused_objects.begin(), state.focused_objects.end(), object.id) != state.focused_objects.end()) view.focused_objects.push_back(&object);
+  }
+  view.player_died = state.player_died;
+  view.mouse_position = state.mouse_position;
+  view.trajectory = state.trajectory;
+  view.tile_revision = state.tile_revision;
+  view.game_over = state.game_over;
+  view.lost = state.lost;
+  view.immovable_player = state.immovable_player;
+  return view;
+}
+
+void Game::poll_input() {
+  std::lock_guard<std::mutex> lock(this->InputMutex);
+
+  // Copy the held state of the mouse, and accumulate any presses and releases since the last update
+  Mouse.position = PendingMouse.position;
+  Mouse.left_button = PendingMouse.left_button;
+  Mouse.right_button = PendingMouse.right_button;
+  Mouse.left_button_down |= PendingMouse.left_button_down;
+  Mouse.left_button_up |= PendingMouse.left_button_up;
+  Mouse.right_button_down |= PendingMouse.right_button_down;
+  Mouse.right_button_up |= PendingMouse.right_button_up;
+  PendingMouse.left_button_down = PendingMouse.left_button_up = false;
+  PendingMouse.right_button_down = PendingMouse.right_button_up = false;
+
+  // Apply every key event since the last update
+  for (auto pair : PendingKeyboard) this->Keyboard[pair.first] = pair.second;
+  PendingKeyboard.clear();
+}
+
+void Game::handle_window_requests() {
+  // Without a window there is nothing to toggle, and closing is left to should_close
+  if (Headless::enabled) return;
+
+  // The toggle changes the size of the window, which the simulation reads, so it has to wait for the tick to end
+  if (this->fullscreen_requested.exchange(false)) {
+    std::lock_guard<std::mutex> lock(this->SimulationMutex);
+    toggle_fullscreen();
+  }
+  if (this->close_requested.exchange(false)) glfwSetWindowShouldClose(this->GameWindow, true);
+}
+
+void Game::step() {
+  std::chrono::high_resolution_clock::time_point start_point = std::chrono::high_resolution_clock::now();
+
+  // Index the scenery as it is after this frame's dragging and swapping, move every dynamic object
+  // and then update all player entities. Nothing moves on its own while a tile is being dragged.
+  bool paused = Mouse.clicked_object != nullptr;
+  GameObjects::index();
+  if (!paused) GameObjects::integrate();
+  Characters::Players::step(paused);
+
+  Physics::tick_count++;
+
+  // When benchmarking a crowd, report how long the ticks are taking every few seconds
+  if (this->crowd) {
+    this->crowd_time += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start_point).count();
+    if (Physics::tick_count % (Physics::TICK_RATE * 5) == 0) {
+      printf("[CROWD] %lu players, %lu objects: %.3f ms per tick (%u threads)\n", Characters::Players::all().size(), GameObjects::all().size(), this->crowd_time * 1000.0 / (Physics::TICK_RATE * 5), Jobs::concurrency());
+      this->crowd_time = 0.0;
+    }
+  }
+
+  // In deterministic mode, checksum the state of every player so runs can be compared tick by tick
+  if (Physics::deterministic) {
+    uint64_t checksum = Physics::CHECKSUM_SEED;
+    for (Player *player : Characters::Players::all()) {
+      checksum = Physics::hash(checksum, Physics::to_fixed(player->transform.position.x));
+      checksum = Physics::hash(checksum, Physics::to_fixed(player->transform.position.y));
+      checksum = Physics::hash(checksum, Physics::to_fixed(player->velocity.x));
+      checksum = Physics::hash(checksum, Physics::to_fixed(player->velocity.y));
+      checksum = Physics::hash(checksum, Physics::to_fixed(player->walk_speed));
+      checksum = Physics::hash(checksum, player->grounded | (player->won << 1) | (player->die << 2));
+    }
+    Physics::checksum = checksum;
+    if (Physics::trace_checksums) printf("[TICK %lu] %016llx\n", Physics::tick_count, (unsigned long long)Physics::checksum);
+  }
+}
+
+void Game::update(double delta) {
+  this->poll_input();
+
   if (!this->state("game-over")) {
     if (Mouse.right_button_down) {
       Characters::Players::ActivePlayer->transform.position = glm::vec3(Mouse.position, 0.0f);
@@ -210,7 +500,7 @@ void Game::update() {
           object->snap = false;
           Mouse.clicked_object = object;
 
-          if (object->check_collision(Characters::Players::ActivePlayer)) {
+          if (Characters::Players::ActivePlayer->touching(object)) {
             Characters::Players::ActivePlayer->old_transform = Characters::Players::ActivePlayer->transform;
             Characters::Players::ActivePlayer->position_offset = glm::vec3(std::fmod(Characters::Players::ActivePlayer->transform.position.x, TileSize.x), std::fmod(Characters::Players::ActivePlayer->transform.position.y, TileSize.y), 0.0f);
             Characters::Players::ActivePlayer->rigidbody = false;
@@ -227,21 +517,23 @@ void Game::update() {
         }
       }
 
-      // If the tile is a background tile, is colliding with the player, and no tile is selected by the mouse, then set the tile as the player's parent tile
-      if (!Mouse.left_button_down && Mouse.clicked_object == nullptr && object->tags[0] == "tile" && object->check_collision(Characters::Players::ActivePlayer)) {
-        p_parent = object;
-      }
-
       // Always update each object's bounding box
       object->update_bounding_box();
     }
 
+    // If no tile is selected by the mouse, then the last background tile the player touched during the last tick becomes its parent tile
+    if (!Mouse.left_button_down && Mouse.clicked_object == nullptr) {
+      for (Contact &contact : Characters::Players::ActivePlayer->contacts)
+        if (contact.object->tags[0] == "tile") p_parent = contact.object;
+    }
+
     // If no object has been clicked, then the parent of the object will be whatever tile the player is colliding with.
     // Otherwise, the parent will not be updated.
     if (Mouse.clicked_object == nullptr) Characters::Players::ActivePlayer->set_parent(p_parent);
     
     // If an object has been selected, then move it and all its children with the mouse
     if (Mouse.focused_objects != std::vector<GameObject *>()) {
+      this->tile_revision++;
       Mouse.clicked_object->originate = true;
       Mouse.clicked_object->translate(screen_to_world(Mouse.position));
 
@@ -252,6 +544,7 @@ void Game::update() {
     }
 
     if (Mouse.left_button_up && !Mouse.left_button_down && !Mouse.left_button && Mouse.clicked_object != nullptr) {
+      this->tile_revision++;
       Mouse.clicked_object->snap = true;
       Mouse.clicked_object->originate = false;
       Mouse.clicked_object->update_snap_position();
@@ -309,26 +602,36 @@ void Game::update() {
       Mouse.focused_objects = std::vector<GameObject *>();
     }
 
-    // Update all player entities
-    for (Player *player : Characters::Players::all()) {
-      if (Mouse.clicked_object == nullptr) {
-        player->resolve_vectors();
-        player->update();
-        player->resolve_collisions();
-      } else {
-        player->update();
-      }
+    // While a tile is being dragged, predict where the player would walk if it was dropped right now
+    if (Mouse.clicked_object != nullptr) {
+      Preview::clone(this->PreviewWorld, Characters::Players::ActivePlayer, Mouse.clicked_object);
+      Preview::simulate(this->PreviewWorld, PREVIEW_TICKS, this->trajectory);
+    } else this->trajectory.clear();
+
+    // Step the physics in fixed ticks, however long the last frame took. The number of ticks per
+    // frame is capped so that a long stall does not make the game spiral trying to catch up.
+    Time::accumulator = std::fmin(Time::accumulator + delta, MAX_TICKS_PER_FRAME * Physics::TICK);
+    while (Time::accumulator >= Physics::TICK) {
+      this->step();
+      Time::accumulator -= Physics::TICK;
     }
 
     if (Characters::Players::ActivePlayer->won) GameState["game-over"] = true;
+
+    // Advance the players' animations while they are moving
+    if (Mouse.clicked_object == nullptr && !state("game-over"))
+      for (Player *player : Characters::Players::all()) player->animate(delta);
   }
 
+  if (Mouse.left_button_down && Characters::Players::ActivePlayer->locked) GameState["immovable-player"] = true;
+  if (state("immovable-player") && !Characters::Players::ActivePlayer->locked) GameState["immovable-player"] = false;
+
   if (Characters::Players::ActivePlayer->die) {
     GameState["game-over"] = true;
     GameState["lost"] = true;
   }
 
-  if (this->Keyboard['F'].pressed) toggle_fullscreen();
+  if (this->Keyboard['F'].pressed) this->fullscreen_requested = true;
 
   // Debug keybinds
   float factor = (Characters::Players::ActivePlayer->walk_speed / std::fabs(Characters::Players::ActivePlayer->walk_speed));
@@ -368,7 +671,7 @@ void Game::update() {
   }
 
   // If the escape key was pressed, then close the window
-  if (Keyboard[GLFW_KEY_ESCAPE].pressed) glfwSetWindowShouldClose(this->GameWindow, true);
+  if (Keyboard[GLFW_KEY_ESCAPE].pressed) this->close_requested = true;
 
   // Reset KeyState::pressed and KeyState::released
   std::vector<int> released_keys;
@@ -380,65 +683,170 @@ void Game::update() {
   for (int key : released_keys) {
     this->Keyboard.erase(this->Keyboard.find(key));
   }
-
-  // Poll GLFW for new events
-  glfwPollEvents();
 }
 
-void Game::render() {
+void Game::render(RenderView view) {
   // Clear the screen (paints it to the predefined clear colour)
   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-  // Render the parallax background
-  const float zoom = 100.0f;
-  const float z_index = 1.0f;
-  glm::vec2 scale = glm::vec2(width + zoom, height + zoom);
-  Renderer->render(ResourceManager::Texture::get("background-bg"), Transform(glm::vec3(0.0f, 0.0f, z_index), scale));
-  Renderer->render(ResourceManager::Texture::get("background-far"), Transform(glm::vec3((Mouse.position / glm::vec2(150.0f)) - glm::vec2(zoom / 2.0f), z_index), scale));
-  Renderer->render(ResourceManager::Texture::get("background-mid"), Transform(glm::vec3((Mouse.position / glm::vec2(100.0f)) - glm::vec2(zoom / 2.0f), z_index), scale));
-  Renderer->render(ResourceManager::Texture::get("background-near"), Transform(glm::vec3((Mouse.position / glm::vec2(50.0f)) - glm::vec2(zoom / 2.0f), z_index), scale));
-
-  // Render everything except the tile GameObject
-  for (GameObject *&object : GameObjects::all()) {
-    if (object->tags[0] != "tile" && std::find(Mouse.focused_objects.begin(), Mouse.focused_objects.end(), object) == Mouse.focused_objects.end() && object != Mouse.clicked_object) {
-      object->render();
+  // Measure how long submitting the frame takes, leaving out the wait for the buffers to swap
+  RenderStats::reset();
+  RenderStats::visible += view.visible.size();
+  RenderStats::culled += view.objects.size() - view.visible.size();
+  std::chrono::high_resolution_clock::time_point start_point = std::chrono::high_resolution_clock::now();
+
+  // Render the parallax background (see required.parallax) in a single pass
+  glm::vec2 mouse_position = view.mouse_position;
+  glm::vec2 screen_size = glm::vec2(width, height);
+  std::function<void()> backgrounds = [mouse_position, screen_size]() { Parallax::render(mouse_position, screen_size); };
+
+  // The backgrounds are cached until the mouse moves
+  unsigned int batch_shader = ResourceManager::Shader::get("batch").id;
+  if (this->cache_layers) {
+    if (mouse_position != this->background_mouse_position) {
+      Backgrounds->invalidate();
+      this->background_mouse_position = mouse_position;
     }
+    Queue->submit(RENDER_BACKGROUND, 0.0f, batch_shader, [backgrounds]() { Backgrounds->render(Batch, backgrounds); });
+  } else {
+    Queue->submit(RENDER_BACKGROUND, 0.0f, batch_shader, [backgrounds]() { backgrounds(); });
   }
 
-  // Render each tile GameObject
-  for (GameObject *&object : GameObjects::all()) {
-    if (object->tags[0] == "tile") {
-      object->render(glm::vec4(1.0f), (object->handle == "immovable") ? 0 : (object->locked) ? -2 : -1);
+  // Objects are drawn on the layer matching what the player is doing with them. The dragged tile and the objects on it
+  // are drawn over everything else, but only while there is something on the tile besides the player.
+  bool dragging = view.clicked_object != nullptr && !view.focused_objects.empty();
+  if (dragging) {
+    for (ObjectSnapshot *object : view.focused_objects) object->render(glm::vec4(1.0f), 0, RENDER_FOCUSED);
+    view.clicked_object->render(glm::vec4(1.0f, 1.0f, 1.0f, 0.5f), 1, RENDER_DRAGGED);
+  }
+
+  std::unordered_set<ObjectSnapshot *> focused(view.focused_objects.begin(), view.focused_objects.end());
+  for (ObjectSnapshot *object : view.visible) {
+    if (object->tile || object->id == view.player->id || object == view.clicked_object || focused.count(object)) continue;
+    object->render();
+  }
+
+  // The player moves along with the tile it stands on
+  glm::vec4 player_colour = view.player_died ? glm::vec4(0.97f, 0.2f, 0.2f, 1.0f) : glm::vec4(1.0f);
+  if (view.clicked_object == nullptr || view.clicked_object != view.player_parent) view.player->render(player_colour, 0, RENDER_PLAYER);
+  else if (dragging) view.player->render(glm::vec4(1.0f), 0, RENDER_DRAGGED_PLAYER);
+
+  // Render the tile layer, after patching it (and invalidating its cache) if any tile moved since it was last drawn
+  if (view.tile_revision != this->drawn_tile_revision) {
+    this->update_tile_layer(view);
+    this->drawn_tile_revision = view.tile_revision;
+    TileCache->invalidate();
+  }
+  if (this->cache_layers) Queue->submit(RENDER_TILES, 0.0f, batch_shader, []() { TileCache->render(Batch, []() { Tiles->render(); }); });
+  else Queue->submit(RENDER_TILES, 0.0f, batch_shader, []() { Tiles->render(); });
+
+  // Render the predicted path of the player while a tile is being dragged
+  if (view.trajectory.size() > 1)
+    Queue->submit(RENDER_PREVIEW, 0.0f, ResourceManager::Shader::get("default").id, [&view]() { Preview::render(view.trajectory, glm::vec4(1.0f, 1.0f, 1.0f, 0.8f)); });
+
+  if (view.immovable_player) 
+    Queue->submit(RENDER_TEXT, 0.0f, TextShader.id, []() { Text::render("Cannot move tiles when player is between two tiles", "monocraft", Transform(glm::vec3(0.0f), glm::vec2(0.6f)), TEXT_MIDDLE_CENTER); });
+
+  if (view.game_over && !view.lost)
+    Queue->submit(RENDER_TEXT, 0.0f, TextShader.id, []() { Text::render("YOU WON!", "monocraft", Transform(glm::vec3(0.0f), glm::vec2(2.0f)), TEXT_MIDDLE_CENTER); });
+  else if (view.game_over && view.lost)
+    Queue->submit(RENDER_TEXT, 0.0f, TextShader.id, []() { Text::render("YOU LOST!", "monocraft", Transform(glm::vec3(0.0f), glm::vec2(2.0f)), TEXT_MIDDLE_CENTER); });
+
+  // Reveal every collider and origin when asked to, then draw the debug shapes of the frame on top of everything but the text
+  if (this->debug_draw) {
+    for (ObjectSnapshot *object : view.visible) {
+      DebugDraw::box(object->bounding_box, glm::vec4(0.2f, 1.0f, 0.4f, 0.8f), 2.0f);
+      DebugDraw::point(glm::vec2(object->transform.position) + object->origin, glm::vec4(1.0f, 0.3f, 0.3f, 0.8f));
     }
   }
+  Queue->submit(RENDER_DEBUG, 0.0f, batch_shader, []() { DebugDraw::flush(); });
+
+  // Sort everything queued this frame and draw it
+  Queue->flush();
 
-  // Render the current active Player
-  if (Mouse.clicked_object == nullptr && !state("game-over")) Characters::Players::ActivePlayer->animate();
-  if (Mouse.clicked_object != Characters::Players::ActivePlayer->parent || Mouse.clicked_object == nullptr) Characters::Players::ActivePlayer->render(Characters::Players::ActivePlayer->die ? glm::vec4(0.97f, 0.2f, 0.2f, 1.0f) : glm::vec4(1.0f));
+  RenderStats::submit_time = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start_point).count();
 
-  // Render the selected object to render them in the front
-  if (Mouse.clicked_object != nullptr && Mouse.focused_objects != std::vector<GameObject *>()) {
-    for (GameObject *&object : Mouse.focused_objects) {
-      object->render();
+  // Sum up the statistics of every frame, and report their average once a second
+  if (this->render_stats) {
+    this->render_totals.add();
+    if (this->render_totals.frames == (unsigned long)Physics::TICK_RATE) {
+      this->render_totals.report("[RENDER]", "frame");
+      this->render_totals = RenderStats::Totals();
     }
+  }
+
+  // Fence off the vertices streamed this frame, and actually display the updated images to the screen
+  StreamBuffer::end_frame();
+  if (Headless::enabled) Headless::swap();
+  else glfwSwapBuffers(this->GameWindow);
+}
 
-    Mouse.clicked_object->render(glm::vec4(1.0f, 1.0f, 1.0f, 0.5f), 1);
-    if (Mouse.clicked_object == Characters::Players::ActivePlayer->parent) Characters::Players::ActivePlayer->render();
+void Game::update_tile_layer(RenderView &view) {
+  std::vector<Sprite> sprites;
+  for (ObjectSnapshot *object : view.objects) {
+    if (!object->tile) continue;
+    sprites.push_back({ object->id, object->texture, object->render_transform, glm::vec4(1.0f), object->immovable ? 0 : object->locked ? -2 : -1 });
   }
 
-  if (Mouse.left_button_down && Characters::Players::ActivePlayer->locked) GameState["immovable-player"] = true;
-  if (state("immovable-player") && !Characters::Players::ActivePlayer->locked) GameState["immovable-player"] = false;
+  // A different set of tiles means that another level was loaded, so the whole layer is rebuilt.
+  // Otherwise only the tiles that changed are patched, which are the dragged tile, or the two tiles of a swap.
+  bool rebuild = sprites.size() != this->tile_sprites.size();
+  for (unsigned int i = 0; i < sprites.size() && !rebuild; i++) {
+    Sprite &sprite = sprites[i], &old = this->tile_sprites[i];
+    if (sprite.key != old.key) rebuild = true;
+    else if (sprite.texture.id != old.texture.id || sprite.texture.uv != old.texture.uv || sprite.texture.layer != old.texture.layer || sprite.focus != old.focus || sprite.transform.position != old.transform.position || sprite.transform.scale != old.transform.scale || sprite.transform.rotation != old.transform.rotation)
+      rebuild = !Tiles->update(sprite);
+  }
+
+  if (rebuild) Tiles->rebuild(sprites);
+  this->tile_sprites = sprites;
+}
+
+void Game::benchmark_sprites(unsigned int count) {
+  const unsigned int frames = 60;
+  std::vector<std::string> handles = { "tile-full-floor", "tile-half-floor", "goal", "obstacle-safe", "obstacle-danger", "nothing" };
+
+  // Scatter the sprites across the screen. They are either grouped by texture, the way the level is mostly drawn,
+  // or mixed so that the texture changes with every sprite, which is the worst case for the batch.
+  std::mt19937 random(0);
+  std::vector<Transform> transforms;
+  std::vector<Texture> grouped, mixed;
+  for (unsigned int i = 0; i < count; i++) {
+    transforms.push_back(Transform(glm::vec3(random() % this->width, random() % this->height, 0.0f), glm::vec2(32.0f)));
+    grouped.push_back(ResourceManager::Texture::get(handles[(i * handles.size()) / count]));
+    mixed.push_back(ResourceManager::Texture::get(handles[i % handles.size()]));
+  }
+
+  auto measure = [&](const char *name, std::vector<Texture> &textures, bool batched) {
+    RenderStats::Totals totals;
 
-  if (state("immovable-player")) 
-    Text::render("Cannot move tiles when player is between two tiles", "monocraft", Transform(glm::vec3(0.0f), glm::vec2(0.6f)), TEXT_MIDDLE_CENTER);
+    for (unsigned int frame = 0; frame < frames; frame++) {
+      glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+      RenderStats::reset();
+
+      std::chrono::high_resolution_clock::time_point start_point = std::chrono::high_resolution_clock::now();
+      for (unsigned int i = 0; i < count; i++) {
+        if (batched) Batch->render(textures[i], transforms[i]);
+        else Renderer->render(textures[i], transforms[i]);
+      }
+      if (batched) Batch->flush();
+      RenderStats::submit_time = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start_point).count();
+      totals.add();
+
+      // The benchmark's frames are not part of a headless run, so they are only flushed, rather than counted and dumped
+      StreamBuffer::end_frame();
+      if (Headless::enabled) glFlush();
+      else glfwSwapBuffers(this->GameWindow);
+    }
 
-  if (state("game-over") && !state("lost"))
-    Text::render("YOU WON!", "monocraft", Transform(glm::vec3(0.0f), glm::vec2(2.0f)), TEXT_MIDDLE_CENTER);
-  else if (state("game-over") && state("lost"))
-    Text::render("YOU LOST!", "monocraft", Transform(glm::vec3(0.0f), glm::vec2(2.0f)), TEXT_MIDDLE_CENTER);
+    totals.report("[BENCH]", name);
+  };
 
-  // Actually display the updated images to the screen
-  glfwSwapBuffers(this->GameWindow);
+  printf("[BENCH] %u sprites, averaged over %u frames\n", count, frames);
+  measure("immediate, grouped", grouped, false);
+  measure("batched, grouped", grouped, true);
+  measure("immediate, mixed", mixed, false);
+  measure("batched, mixed", mixed, true);
 }
 
 void Game::set_window_hints() {
@@ -493,14 +901,17 @@ void Game::toggle_fullscreen() {
     refresh = mode->refreshRate;
   }
 
-  // Update the OpenGL viewport
+  // Update the OpenGL viewport, and the cached layers drawn into it
   glViewport(0, 0, width, height);
+  Backgrounds->resize(width, height);
+  TileCache->resize(width, height);
 
   // Here, the command `*Camera->resize(width, height);` must be run for a Camera object if the objects are expected to
   // have absolute sizes irrespective of the screen size. If the objects are expected to keep the same size regardless of
   // the window size, then resize the camera's matrices here.
   WindowSize = glm::vec2(width, height);
 
-  // Toggle the window fullscreen state
+  // Toggle the window fullscreen state, and set the vsync up again, as some platforms reset it with the mode
   glfwSetWindowMonitor(this->GameWindow, this->fullscreen ? glfwGetPrimaryMonitor() : nullptr, 0, 0, width, height, refresh);
+  FramePacer::init();
 }
@@ -0,0 +1,148 @@
+#include "gl_state.h"
+
+// The value of every tracked piece of state. Anything that is not known is ~0, which never matches a real value.
+static const unsigned int UNKNOWN = ~0u;
+
+static unsigned int program = UNKNOWN;
+static unsigned int vertex_array = UNKNOWN;
+static unsigned int array_buffer = UNKNOWN, element_buffer = UNKNOWN, uniform_buffer = UNKNOWN;
+static unsigned int active_unit = UNKNOWN;
+static unsigned int textures_2d[GLState::TEXTURE_UNITS], texture_arrays[GLState::TEXTURE_UNITS];
+static unsigned int framebuffer = UNKNOWN;
+
+// The framebuffer binding 0 is redirected to, which is the window's own unless running headless
+static unsigned int screen_framebuffer = 0;
+static unsigned int blending = UNKNOWN, blend_source = UNKNOWN, blend_destination = UNKNOWN;
+static unsigned int blend_source_alpha = UNKNOWN, blend_destination_alpha = UNKNOWN;
+static bool initialised = false;
+
+// Count a call that is about to be made or was dropped, and return whether it has to be made
+static bool changed(unsigned int &current, unsigned int value) {
+  if (!initialised) GLState::invalidate();
+
+  if (current == value) {
+    RenderStats::state_elided++;
+    return false;
+  }
+
+  current = value;
+  RenderStats::state_calls++;
+  return true;
+}
+
+void GLState::use_program(unsigned int id) {
+  if (changed(program, id)) glUseProgram(id);
+}
+
+void GLState::bind_vertex_array(unsigned int vao) {
+  if (!changed(vertex_array, vao)) return;
+  glBindVertexArray(vao);
+
+  // The element buffer binding is part of the vertex array, so it is unknown after switching to another one
+  element_buffer = UNKNOWN;
+}
+
+void GLState::bind_buffer(GLenum target, unsigned int buffer) {
+  unsigned int *current;
+  switch (target) {
+    case GL_ARRAY_BUFFER: current = &array_buffer; break;
+    case GL_ELEMENT_ARRAY_BUFFER: current = &element_buffer; break;
+    case GL_UNIFORM_BUFFER: current = &uniform_buffer; break;
+    default: {
+      glBindBuffer(target, buffer);
+      return;
+    }
+  }
+
+  if (changed(*current, buffer)) glBindBuffer(target, buffer);
+}
+
+void GLState::bind_texture(unsigned int unit, GLenum target, unsigned int texture) {
+  if (unit >= GLState::TEXTURE_UNITS) {
+    printf("[WARNING] Texture unit %u is not tracked by GLState\n", unit);
+    glActiveTexture(GL_TEXTURE0 + unit);
+    glBindTexture(target, texture);
+    active_unit = unit;
+    return;
+  }
+
+  unsigned int &current = (target == GL_TEXTURE_2D_ARRAY) ? texture_arrays[unit] : textures_2d[unit];
+  if (current == texture) {
+    RenderStats::state_elided++;
+    return;
+  }
+
+  if (changed(active_unit, unit)) glActiveTexture(GL_TEXTURE0 + unit);
+  if (changed(current, texture)) glBindTexture(target, texture);
+}
+
+void GLState::edit_texture(GLenum target, unsigned int texture) {
+  if (changed(active_unit, 0)) glActiveTexture(GL_TEXTURE0);
+  GLState::bind_texture(0, target, texture);
+}
+
+void GLState::bind_framebuffer(unsigned int id) {
+  if (id == 0) id = screen_framebuffer;
+  if (changed(framebuffer, id)) glBindFramebuffer(GL_FRAMEBUFFER, id);
+}
+
+void GLState::set_screen_framebuffer(unsigned int id) {
+  screen_framebuffer = id;
+}
+
+void GLState::blend(bool enabled, GLenum source, GLenum destination, GLenum source_alpha, GLenum destination_alpha) {
+  if (changed(blending, enabled)) {
+    if (enabled) glEnable(GL_BLEND);
+    else glDisable(GL_BLEND);
+  }
+
+  if (!enabled) return;
+
+  // Every factor is set by one call, so only count it once
+  if (blend_source != source || blend_destination != destination || blend_source_alpha != source_alpha || blend_destination_alpha != destination_alpha) {
+    blend_source = source;
+    blend_destination = destination;
+    blend_source_alpha = source_alpha;
+    blend_destination_alpha = destination_alpha;
+    glBlendFuncSeparate(source, destination, source_alpha, destination_alpha);
+    RenderStats::state_calls++;
+  } else {
+    RenderStats::state_elided++;
+  }
+}
+
+void GLState::forget_program(unsigned int id) {
+  if (program == id) program = UNKNOWN;
+}
+
+void GLState::forget_vertex_array(unsigned int vao) {
+  if (vertex_array == vao) vertex_array = UNKNOWN;
+}
+
+void GLState::forget_buffer(unsigned int buffer) {
+  if (array_buffer == buffer) array_buffer = UNKNOWN;
+  if (element_buffer == buffer) element_buffer = UNKNOWN;
+  if (uniform_buffer == buffer) uniform_buffer = UNKNOWN;
+}
+
+void GLState::forget_texture(unsigned int texture) {
+  for (unsigned int unit = 0; unit < GLState::TEXTURE_UNITS; unit++) {
+    if (textures_2d[unit] == texture) textures_2d[unit] = UNKNOWN;
+    if (texture_arrays[unit] == texture) texture_arrays[unit] = UNKNOWN;
+  }
+}
+
+void GLState::forget_framebuffer(unsigned int id) {
+  if (framebuffer == id) framebuffer = UNKNOWN;
+}
+
+void GLState::invalidate() {
+  initialised = true;
+  program = vertex_array = UNKNOWN;
+  array_buffer = element_buffer = uniform_buffer = UNKNOWN;
+  active_unit = UNKNOWN;
+  for (unsigned int unit = 0; unit < GLState::TEXTURE_UNITS; unit++) textures_2d[unit] = texture_arrays[unit] = UNKNOWN;
+  framebuffer = UNKNOWN;
+  blending = blend_source = blend_destination = UNKNOWN;
+  blend_source_alpha = blend_destination_alpha = UNKNOWN;
+}
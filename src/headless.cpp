@@ -0,0 +1,237 @@
+// Keep Xlib out of the EGL headers, as nothing here talks to X
+#define EGL_NO_X11
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <sys/stat.h>
+
+#include "headless.h"
+
+bool Headless::enabled = false;
+unsigned int Headless::frames = 600;
+std::string Headless::dump_directory = "";
+unsigned int Headless::dump_every = 1;
+unsigned int Headless::frame = 0;
+
+// The EGL objects, and the framebuffer the frames are drawn into with its attachments
+static EGLDisplay display = EGL_NO_DISPLAY;
+static EGLContext context = EGL_NO_CONTEXT;
+static EGLSurface surface = EGL_NO_SURFACE;
+static unsigned int framebuffer = 0, colour_buffer = 0, depth_buffer = 0;
+static unsigned int framebuffer_width = 0, framebuffer_height = 0;
+
+// Scratch space for the pixels of the frames being dumped
+static std::vector<uint8_t> frame_pixels, frame_rows;
+
+static bool has_extension(const char *extensions, const std::string &name) {
+  if (extensions == nullptr) return false;
+  std::string list = std::string(" ") + extensions + " ";
+  return list.find(" " + name + " ") != std::string::npos;
+}
+
+static GLADapiproc get_proc_address(const char *name) {
+  return (GLADapiproc)eglGetProcAddress(name);
+}
+
+bool Headless::init(unsigned int width, unsigned int height) {
+  // Prefer the surfaceless platform, which needs neither a display server nor a GPU, over whatever EGL picks itself
+  const char *client_extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+  if (has_extension(client_extensions, "EGL_MESA_platform_surfaceless")) {
+    PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (get_platform_display != nullptr) display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+  }
+  if (display == EGL_NO_DISPLAY) display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+  EGLint major, minor;
+  if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor)) {
+    printf("[ERROR] EGL display could not be initialised!\n");
+    return false;
+  }
+
+  // Without surfaceless contexts, the context is made current on a tiny pbuffer, as everything is drawn offscreen anyway
+  bool surfaceless = has_extension(eglQueryString(display, EGL_EXTENSIONS), "EGL_KHR_surfaceless_context");
+  const EGLint config_attributes[] = {
+    EGL_SURFACE_TYPE, surfaceless ? 0 : EGL_PBUFFER_BIT,
+    EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+    EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_ALPHA_SIZE, 8,
+    EGL_NONE
+  };
+  EGLConfig config;
+  EGLint configs = 0;
+  if (!eglChooseConfig(display, config_attributes, &config, 1, &configs) || configs == 0 || !eglBindAPI(EGL_OPENGL_API)) {
+    printf("[ERROR] EGL has no config for desktop OpenGL!\n");
+    return false;
+  }
+
+  // Ask for the same version and profile the window would get
+  const EGLint context_attributes[] = {
+    EGL_CONTEXT_MAJOR_VERSION, 3,
+    EGL_CONTEXT_MINOR_VERSION, 3,
+    EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+    EGL_NONE
+  };
+  context = eglCreateContext(display, config, EGL_NO_CONTEXT, context_attributes);
+  if (context == EGL_NO_CONTEXT) {
+    printf("[ERROR] EGL could not create an OpenGL 3.3 core context!\n");
+    return false;
+  }
+
+  if (!surfaceless) {
+    const EGLint pbuffer_attributes[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+    surface = eglCreatePbufferSurface(display, config, pbuffer_attributes);
+  }
+  if (!eglMakeCurrent(display, surface, surface, context) || !gladLoadGL(get_proc_address)) {
+    printf("[ERROR] EGL context could not be made current!\n");
+    return false;
+  }
+
+  // Draw into a framebuffer of the same size as the window would have been
+  framebuffer_width = width;
+  framebuffer_height = height;
+  glGenFramebuffers(1, &framebuffer);
+  glGenRenderbuffers(1, &colour_buffer);
+  glGenRenderbuffers(1, &depth_buffer);
+  glBindRenderbuffer(GL_RENDERBUFFER, colour_buffer);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+  glBindRenderbuffer(GL_RENDERBUFFER, depth_buffer);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+  glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+  GLState::set_screen_framebuffer(framebuffer);
+  GLState::bind_framebuffer(0);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colour_buffer);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depth_buffer);
+  if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+    printf("[ERROR] Headless framebuffer is incomplete!\n");
+    return false;
+  }
+
+  if (!Headless::dump_directory.empty()) mkdir(Headless::dump_directory.c_str(), 0755);
+  printf("[HEADLESS] Rendering %u frames offscreen with %s\n", Headless::frames, (const char *)glGetString(GL_RENDERER));
+  return true;
+}
+
+void Headless::destroy() {
+  if (display == EGL_NO_DISPLAY) return;
+
+  if (framebuffer != 0) {
+    GLState::forget_framebuffer(framebuffer);
+    glDeleteFramebuffers(1, &framebuffer);
+    glDeleteRenderbuffers(1, &colour_buffer);
+    glDeleteRenderbuffers(1, &depth_buffer);
+    framebuffer = 0;
+  }
+
+  eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+  if (surface != EGL_NO_SURFACE) eglDestroySurface(display, surface);
+  if (context != EGL_NO_CONTEXT) eglDestroyContext(display, context);
+  eglTerminate(display);
+  display = EGL_NO_DISPLAY;
+  context = EGL_NO_CONTEXT;
+  surface = EGL_NO_SURFACE;
+}
+
+void Headless::swap() {
+  // Nothing presents the frame, so make sure the driver actually gets to drawing it
+  glFlush();
+
+  bool due = !Headless::dump_directory.empty() && Headless::dump_every > 0 && Headless::frame % Headless::dump_every == 0;
+  if (due) {
+    unsigned int width = framebuffer_width, height = framebuffer_height;
+    frame_pixels.resize(width * height * 3);
+    frame_rows.resize(width * height * 3);
+
+    GLState::bind_framebuffer(0);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, frame_pixels.data());
+
+    // GL reads the rows from the bottom up
+    for (unsigned int y = 0; y < height; y++)
+      std::copy(frame_pixels.begin() + (height - 1 - y) * width * 3, frame_pixels.begin() + (height - y) * width * 3, frame_rows.begin() + y * width * 3);
+
+    char name[32];
+    snprintf(name, sizeof(name), "/frame%05u.png", Headless::frame);
+    Headless::write_png(Headless::dump_directory + name, width, height, frame_rows);
+  }
+
+  Headless::frame++;
+}
+
+bool Headless::done() {
+  return Headless::frame >= Headless::frames;
+}
+
+// The CRC-32 of PNG chunks, from the table of the polynomial 0xedb88320
+static uint32_t png_crc(uint32_t crc, const uint8_t *data, size_t size) {
+  static uint32_t table[256];
+  if (table[1] == 0) {
+    for (uint32_t i = 0; i < 256; i++) {
+      uint32_t c = i;
+      for (int k = 0; k < 8; k++) c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+      table[i] = c;
+    }
+  }
+
+  crc = ~crc;
+  for (size_t i = 0; i < size; i++) crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+  return ~crc;
+}
+
+static void put_u32(std::vector<uint8_t> &out, uint32_t value) {
+  for (int shift = 24; shift >= 0; shift -= 8) out.push_back((value >> shift) & 0xff);
+}
+
+// Append a chunk with its length, type, data and CRC
+static void put_chunk(std::vector<uint8_t> &out, const char *type, const std::vector<uint8_t> &data) {
+  put_u32(out, data.size());
+  size_t start = out.size();
+  out.insert(out.end(), type, type + 4);
+  out.insert(out.end(), data.begin(), data.end());
+  put_u32(out, png_crc(0, &out[start], out.size() - start));
+}
+
+bool Headless::write_png(const std::string &path, unsigned int width, unsigned int height, const std::vector<uint8_t> &pixels) {
+  std::vector<uint8_t> header;
+  put_u32(header, width);
+  put_u32(header, height);
+  header.insert(header.end(), { 8, 2, 0, 0, 0 });  // 8 bits per channel, RGB, deflate, no filtering, no interlacing
+
+  // Every row starts with its filter type (none). The rows are stored in a zlib stream of uncompressed deflate blocks,
+  // which keeps the encoder trivial at the cost of the file size.
+  std::vector<uint8_t> raw;
+  raw.reserve((width * 3 + 1) * height);
+  for (unsigned int y = 0; y < height; y++) {
+    raw.push_back(0);
+    raw.insert(raw.end(), pixels.begin() + y * width * 3, pixels.begin() + (y + 1) * width * 3);
+  }
+
+  std::vector<uint8_t> data = { 0x78, 0x01 };
+  const size_t BLOCK = 65535;
+  for (size_t offset = 0; offset < raw.size() || offset == 0; offset += BLOCK) {
+    size_t size = std::min(BLOCK, raw.size() - offset);
+    bool last = offset + size >= raw.size();
+    data.insert(data.end(), { (uint8_t)last, (uint8_t)(size & 0xff), (uint8_t)(size >> 8), (uint8_t)(~size & 0xff), (uint8_t)((~size >> 8) & 0xff) });
+    data.insert(data.end(), raw.begin() + offset, raw.begin() + offset + size);
+    if (last) break;
+  }
+
+  uint32_t a = 1, b = 0;
+  for (uint8_t byte : raw) {
+    a = (a + byte) % 65521;
+    b = (b + a) % 65521;
+  }
+  put_u32(data, (b << 16) | a);
+
+  std::vector<uint8_t> png = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+  put_chunk(png, "IHDR", header);
+  put_chunk(png, "IDAT", data);
+  put_chunk(png, "IEND", {});
+
+  FILE *file = fopen(path.c_str(), "wb");
+  if (file == nullptr) {
+    printf("[ERROR] Could not write frame to '%s'\n", path.c_str());
+    return false;
+  }
+  fwrite(png.data(), 1, png.size(), file);
+  fclose(file);
+  return true;
+}
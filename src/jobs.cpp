@@ -0,0 +1,98 @@
+#include "jobs.h"
+
+#include <algorithm>
+
+// The state shared between the worker threads, allocated once the workers are first needed and freed by Jobs::shutdown
+struct Pool {
+  std::vector<std::thread> workers;
+  std::mutex mutex;
+  std::condition_variable work_ready, work_done;
+
+  // The batch currently being processed
+  std::function<void(unsigned int, unsigned int)> function;
+  unsigned int count = 0, grain = 1;
+  std::atomic<unsigned int> next { 0 };
+
+  // Incremented for every new batch, so workers can tell a new batch from a spurious wake-up
+  unsigned long generation = 0;
+
+  // The number of workers which have not finished the current batch yet
+  unsigned int busy = 0;
+
+  // Tells the workers to return instead of waiting for another batch
+  bool stopping = false;
+};
+
+static Pool *WorkerPool = nullptr;
+
+// Process chunks of the current batch until none are left
+static void run_chunks(Pool *pool) {
+  unsigned int begin;
+  while ((begin = pool->next.fetch_add(pool->grain)) < pool->count) {
+    pool->function(begin, std::min(begin + pool->grain, pool->count));
+  }
+}
+
+static void work(Pool *pool) {
+  unsigned long seen = 0;
+  while (true) {
+    std::unique_lock<std::mutex> lock(pool->mutex);
+    pool->work_ready.wait(lock, [&]() { return pool->generation != seen || pool->stopping; });
+    if (pool->stopping) return;
+    seen = pool->generation;
+    lock.unlock();
+
+    run_chunks(pool);
+
+    lock.lock();
+    if (--pool->busy == 0) pool->work_done.notify_one();
+  }
+}
+
+unsigned int Jobs::concurrency() {
+  return std::max(1u, std::thread::hardware_concurrency());
+}
+
+void Jobs::parallel_for(unsigned int count, std::function<void(unsigned int begin, unsigned int end)> function, unsigned int grain) {
+  if (count <= grain || Jobs::concurrency() == 1) {
+    function(0, count);
+    return;
+  }
+
+  // Start the workers the first time they are needed. The calling thread also works on each batch.
+  if (WorkerPool == nullptr) {
+    WorkerPool = new Pool();
+    for (unsigned int i = 1; i < Jobs::concurrency(); i++) WorkerPool->workers.push_back(std::thread(work, WorkerPool));
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(WorkerPool->mutex);
+    WorkerPool->function = function;
+    WorkerPool->count = count;
+    WorkerPool->grain = grain;
+    WorkerPool->next = 0;
+    WorkerPool->busy = WorkerPool->workers.size();
+    WorkerPool->generation++;
+  }
+  WorkerPool->work_ready.notify_all();
+
+  run_chunks(WorkerPool);
+
+  // Wait for every worker to finish, even the ones that found no chunks left, so the batch can be safely replaced
+  std::unique_lock<std::mutex> lock(WorkerPool->mutex);
+  WorkerPool->work_done.wait(lock, []() { return WorkerPool->busy == 0; });
+}
+
+void Jobs::shutdown() {
+  if (WorkerPool == nullptr) return;
+
+  {
+    std::lock_guard<std::mutex> lock(WorkerPool->mutex);
+    WorkerPool->stopping = true;
+  }
+  WorkerPool->work_ready.notify_all();
+
+  for (std::thread &worker : WorkerPool->workers) worker.join();
+  delete WorkerPool;
+  WorkerPool = nullptr;
+}
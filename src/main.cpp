@@ -1,3 +1,8 @@
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <cmath>
+
 #include "game.h"
 
 // Create a pointer to the Game instance
@@ -8,50 +13,147 @@ void mouse_button_callback(GLFWwindow *window, int button, int action, int mods)
 void mouse_callback(GLFWwindow *window, double x, double y);
 void keyboard_callback(GLFWwindow *window, int key, int scancode, int action, int mode);
 
-int main() {
+// Read the value of a numeric flag. Anything but a number from the minimum up is warned about, like an unknown flag
+// would be, and leaves the setting as it was.
+bool parse_number(const char *flag, const char *value, unsigned int minimum, unsigned int &out);
+bool parse_number(const char *flag, const char *value, double minimum, double &out);
+
+int main(int argc, char **argv) {
+  bool threaded = false;
+  unsigned int crowd = 0;
+  unsigned int bench_sprites = 0;
+  bool render_stats = false;
+  bool debug_draw = false;
+  bool cache_layers = true;
+
+  // Parse the command-line flags
+  for (int i = 1; i < argc; i++) {
+    std::string flag = argv[i];
+    if (flag == "--deterministic") Physics::deterministic = true;
+    else if (flag == "--trace-checksums") Physics::deterministic = Physics::trace_checksums = true;
+    else if (flag == "--threaded") threaded = true;
+    else if (flag == "--crowd" && i + 1 < argc) parse_number(flag.c_str(), argv[++i], 1u, crowd);
+    else if (flag == "--no-atlas") ResourceManager::Atlas::enabled = false;
+    else if (flag == "--render-stats") render_stats = true;
+    else if (flag == "--debug-draw") debug_draw = true;
+    else if (flag == "--no-layer-cache") cache_layers = false;
+    else if (flag == "--no-buffer-storage") StreamBuffer::persistent = false;
+    else if (flag == "--bench-sprites" && i + 1 < argc) parse_number(flag.c_str(), argv[++i], 1u, bench_sprites);
+    else if (flag == "--fps-cap" && i + 1 < argc) parse_number(flag.c_str(), argv[++i], 0.0, FramePacer::fps_cap);
+    else if (flag == "--uncapped") FramePacer::uncapped = true;
+    else if (flag == "--pacing-stats") FramePacer::report = true;
+    else if (flag == "--headless") Headless::enabled = true;
+    else if (flag == "--frames" && i + 1 < argc) parse_number(flag.c_str(), argv[++i], 1u, Headless::frames);
+    else if (flag == "--dump-frames" && i + 1 < argc) Headless::dump_directory = argv[++i];
+    else if (flag == "--dump-every" && i + 1 < argc) parse_number(flag.c_str(), argv[++i], 1u, Headless::dump_every);
+    else if (flag == "--vsync" && i + 1 < argc) {
+      std::string mode = argv[++i];
+      if (mode == "off") FramePacer::vsync = VSYNC_OFF;
+      else if (mode == "on") FramePacer::vsync = VSYNC_ON;
+      else if (mode == "adaptive") FramePacer::vsync = VSYNC_ADAPTIVE;
+      else printf("[WARNING] Unknown vsync mode '%s'\n", mode.c_str());
+    }
+    else printf("[WARNING] Unknown flag '%s'\n", argv[i]);
+  }
+
+  // The sprite benchmark measures every frame it can render, and so does the headless mode, which has no display to
+  // pace it by
+  if (bench_sprites || Headless::enabled) FramePacer::uncapped = true;
+
   // Create a new Game with the given parameters
   RosewaltzJourney = new Game(1280, 720, "Rosewaltz Journey");
+  RosewaltzJourney->threaded = threaded;
+  RosewaltzJourney->render_stats = render_stats;
+  RosewaltzJourney->debug_draw = debug_draw;
+  RosewaltzJourney->cache_layers = cache_layers;
 
-  // Set callback handlers for the game
-  RosewaltzJourney->set_callbacks(mouse_callback, mouse_button_callback, keyboard_callback);
+  // Benchmark the sprite renderers on a stress scene instead of running the game
+  if (bench_sprites) {
+    RosewaltzJourney->benchmark_sprites(bench_sprites);
+    delete RosewaltzJourney;
+    return 0;
+  }
+
+  // Benchmark a crowd of walkers on a large generated level
+  if (crowd) {
+    RosewaltzJourney->crowd = crowd;
+    RosewaltzJourney->generate_level(100, 30, crowd);
+  }
+
+  // Set callback handlers for the game, unless there is no window to receive any input
+  if (!Headless::enabled) RosewaltzJourney->set_callbacks(mouse_callback, mouse_button_callback, keyboard_callback);
 
   // Run the game (including both render() and update())
   RosewaltzJourney->run();
 
+  // Release the window (or the offscreen context), every resource and the worker threads before exiting
+  delete RosewaltzJourney;
+
   // If the game exits, then exit the application
   return 0;
 }
 
+bool parse_number(const char *flag, const char *value, unsigned int minimum, unsigned int &out) {
+  char *end;
+  errno = 0;
+  long number = strtol(value, &end, 10);
+  if (end == value || *end != '\0' || errno == ERANGE || number < (long)minimum || number > (long)UINT_MAX) {
+    printf("[WARNING] Invalid value '%s' for flag '%s'\n", value, flag);
+    return false;
+  }
+
+  out = (unsigned int)number;
+  return true;
+}
+
+bool parse_number(const char *flag, const char *value, double minimum, double &out) {
+  char *end;
+  errno = 0;
+  double number = strtod(value, &end);
+  if (end == value || *end != '\0' || errno == ERANGE || !std::isfinite(number) || number < minimum) {
+    printf("[WARNING] Invalid value '%s' for flag '%s'\n", value, flag);
+    return false;
+  }
+
+  out = number;
+  return true;
+}
+
 // Mouse callback function
 void mouse_button_callback(GLFWwindow* window, int button, int action, int mods) {
+  std::lock_guard<std::mutex> lock(RosewaltzJourney->InputMutex);
+
   if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS) {
-    RosewaltzJourney->Mouse.left_button = true;
-    RosewaltzJourney->Mouse.left_button_down = true;
+    RosewaltzJourney->PendingMouse.left_button = true;
+    RosewaltzJourney->PendingMouse.left_button_down = true;
   } else if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_RELEASE) {
-    RosewaltzJourney->Mouse.left_button = false;
-    RosewaltzJourney->Mouse.left_button_up = true;
+    RosewaltzJourney->PendingMouse.left_button = false;
+    RosewaltzJourney->PendingMouse.left_button_up = true;
   }
 
   if (button == GLFW_MOUSE_BUTTON_RIGHT && action == GLFW_PRESS) {
-    RosewaltzJourney->Mouse.right_button = true;
-    RosewaltzJourney->Mouse.right_button_down = true;
+    RosewaltzJourney->PendingMouse.right_button = true;
+    RosewaltzJourney->PendingMouse.right_button_down = true;
   } else if (button == GLFW_MOUSE_BUTTON_RIGHT && action == GLFW_RELEASE) {
-    RosewaltzJourney->Mouse.right_button = false;
-    RosewaltzJourney->Mouse.right_button_up = true;
+    RosewaltzJourney->PendingMouse.right_button = false;
+    RosewaltzJourney->PendingMouse.right_button_up = true;
   }
 }
 
 // Callback function to update the position of the mouse
 void mouse_callback(GLFWwindow* window, double x, double y) {
-  RosewaltzJourney->Mouse.position = glm::vec2(x, y);
+  std::lock_guard<std::mutex> lock(RosewaltzJourney->InputMutex);
+  RosewaltzJourney->PendingMouse.position = glm::vec2(x, y);
 }
 
 // Callback function to interact with the keyboard
 void keyboard_callback(GLFWwindow *window, int key, int scancode, int action, int mode) {
+  std::lock_guard<std::mutex> lock(RosewaltzJourney->InputMutex);
+
   if (key >= 0) {
     if (action == GLFW_PRESS)
-      RosewaltzJourney->Keyboard[key] = { true, true, false };
+      RosewaltzJourney->PendingKeyboard[key] = { true, true, false };
     else if (action == GLFW_RELEASE)
-      RosewaltzJourney->Keyboard[key] = { false, false, true };
+      RosewaltzJourney->PendingKeyboard[key] = { false, false, true };
   }
 }
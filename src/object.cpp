@@ -1,17 +1,31 @@
 #include "object.h"
+#include "jobs.h"
 
 // Publically store the active Camera and the Renderer
 OrthoCamera *GameObjects::Camera = new OrthoCamera(WindowSize.x, WindowSize.y, 1000.0f, -1000.0f);
 SpriteRenderer *GameObjects::Renderer = nullptr;
+SpriteBatch *GameObjects::Batch = nullptr;
+RenderQueue *GameObjects::Queue = nullptr;
 
-// Store a list of all the GameObjects and Prefabs ever created
-std::map<unsigned long, GameObject> Objects;
+// Store a list of all the GameObjects and Prefabs ever created.
+// Objects are stored as pointers so that derived objects, like a Player, can live alongside them.
+std::map<unsigned long, GameObject *> Objects;
 std::map<std::string, GameObject> Prefabs;
 
+// The spatial index over the scenery, and the objects each of its items refer to.
+// The sprites are indexed separately, as casts need the colliders alone, and refer to the same objects.
+Physics::SpatialGrid Grid;
+Physics::SpatialGrid SpriteGrid;
+std::vector<GameObject *> Indexed;
+
+// The dynamic objects being integrated, and their bodies laid out for the integrator
+std::vector<GameObject *> Dynamic;
+Physics::Bodies Bodies;
+
 // Counter to keep track of the next id for instantiated GameObjects
 static unsigned long instantiation_id = 0;
 
-void GameObject::render(glm::vec4 colour, int focus) {
+Transform GameObject::render_transform() {
   Transform n_transform = this->transform;
   n_transform.position += this->position_offset;
   if (this->flip_x) {
@@ -20,113 +34,46 @@ void GameObject::render(glm::vec4 colour, int focus) {
   }
   if (this->flip_y) n_transform.scale.y *= -1.0f;
   // if (this->tags[0] == "tile") n_transform.scale += glm::vec2(2.0f);
+  return n_transform;
+}
 
-  if (this->active) {
-    if (this->transform.position.z >= GameObjects::Camera->far || this->transform.position.z <= GameObjects::Camera->near) {
-      printf("[WARNING] Object (%i) %s has z-index out of the camera's range.", this->id, this->handle.c_str());
-    }
+BoundingBox GameObject::render_bounds() {
+  // A flipped sprite has a negative scale, so it reaches back from its position
+  Transform transform = this->render_transform();
+  return BoundingBox(
+    transform.position.y + std::fmin(transform.scale.y, 0.0f), transform.position.y + std::fmax(transform.scale.y, 0.0f),
+    transform.position.x + std::fmin(transform.scale.x, 0.0f), transform.position.x + std::fmax(transform.scale.x, 0.0f)
+  );
+}
 
-    if (this->collider_revealed) {
-      unsigned int t_vao, t_vbo;
-      glGenVertexArrays(1, &t_vao);
-      glGenBuffers(1, &t_vbo);
-      glBindVertexArray(t_vao);
-      glBindBuffer(GL_ARRAY_BUFFER, t_vbo);
-      glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 6 * 4, nullptr, GL_DYNAMIC_DRAW);
-      glEnableVertexAttribArray(0);
-      glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), 0);
-      glBindBuffer(GL_ARRAY_BUFFER, 0);
-      glBindVertexArray(0);
-      Shader shader = ResourceManager::Shader::get("default");
-      shader.activate();
-      shader.set_vector_4f("colour", glm::vec4(0.5f));
-      shader.set_matrix_4f("projection", GameObjects::Camera->projection_matrix);
-      shader.set_matrix_4f("model", glm::mat4(1.0f));
-      shader.set_matrix_4f("view", glm::mat4(1.0f));
-      glActiveTexture(GL_TEXTURE0);
-      glBindVertexArray(t_vao);
-
-      float xpos = this->transform.position.x + this->position_offset.x;
-      float ypos = this->transform.position.y + this->position_offset.y;
-      float w = this->transform.scale.x;
-      float h = this->transform.scale.y;
-
-      float vertices[6][4] = {
-        { xpos,     ypos + h,   0.0f, 1.0f },            
-        { xpos,     ypos,       0.0f, 0.0f },
-        { xpos + w, ypos,       1.0f, 0.0f },
-
-        { xpos,     ypos + h,   0.0f, 1.0f },
-        { xpos + w, ypos,       1.0f, 0.0f },
-        { xpos + w, ypos + h,   1.0f, 1.0f }           
-      };
-
-      glBindTexture(GL_TEXTURE_2D, ResourceManager::Texture::get("blank").id);
-
-      // Update the content of the VBO buffer
-      glBindBuffer(GL_ARRAY_BUFFER, t_vbo);
-      glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices); 
-      glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-      // Draw the buffer onto the screen
-      glDrawArrays(GL_TRIANGLES, 0, 6);
-
-      // Unbind the VAOs and the textures
-      glBindVertexArray(0);
-      glBindTexture(GL_TEXTURE_2D, 0);
-    }
+ObjectSnapshot GameObject::snapshot() {
+  ObjectSnapshot snapshot;
+  snapshot.id = this->id;
+  snapshot.transform = this->transform;
+  snapshot.position_offset = this->position_offset;
+  snapshot.origin = this->origin;
+  snapshot.bounding_box = this->bounding_box;
+  snapshot.texture = this->texture[this->texture_index];
+  snapshot.render_transform = this->render_transform();
+  snapshot.tile = this->tags.size() && this->tags[0] == "tile";
+  snapshot.immovable = this->handle == "immovable";
+  snapshot.locked = this->locked;
+  snapshot.collider_revealed = this->collider_revealed;
+  return snapshot;
+}
 
-    GameObjects::Renderer->render(this->texture[this->texture_index], n_transform, colour, focus);
-
-    if (this->collider_revealed) {
-      unsigned int t_vao, t_vbo;
-      glGenVertexArrays(1, &t_vao);
-      glGenBuffers(1, &t_vbo);
-      glBindVertexArray(t_vao);
-      glBindBuffer(GL_ARRAY_BUFFER, t_vbo);
-      glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 6 * 4, nullptr, GL_DYNAMIC_DRAW);
-      glEnableVertexAttribArray(0);
-      glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), 0);
-      glBindBuffer(GL_ARRAY_BUFFER, 0);
-      glBindVertexArray(0);
-      Shader shader = ResourceManager::Shader::get("default");
-      shader.activate();
-      shader.set_vector_4f("colour", glm::vec4(1.0f, 0.3f, 0.3f, 0.8f));
-      shader.set_matrix_4f("projection", GameObjects::Camera ->projection_matrix);
-      shader.set_matrix_4f("model", glm::mat4(1.0f));
-      shader.set_matrix_4f("view", glm::mat4(1.0f));
-      glActiveTexture(GL_TEXTURE0);
-      glBindVertexArray(t_vao);
-
-      float xpos = this->transform.position.x + this->position_offset.x + this->origin.x;
-      float ypos = this->transform.position.y + this->position_offset.y + this->origin.y;
-      float w = 10.0f;
-      float h = 10.0f;
-
-      float vertices[6][4] = {
-        { xpos,     ypos + h,   0.0f, 1.0f },            
-        { xpos,     ypos,       0.0f, 0.0f },
-        { xpos + w, ypos,       1.0f, 0.0f },
-
-        { xpos,     ypos + h,   0.0f, 1.0f },
-        { xpos + w, ypos,       1.0f, 0.0f },
-        { xpos + w, ypos + h,   1.0f, 1.0f }           
-      };
-
-      glBindTexture(GL_TEXTURE_2D, ResourceManager::Texture::get("blank").id);
-
-      // Update the content of the VBO buffer
-      glBindBuffer(GL_ARRAY_BUFFER, t_vbo);
-      glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices); 
-      glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-      // Draw the buffer onto the screen
-      glDrawArrays(GL_TRIANGLES, 0, 6);
-
-      // Unbind the VAOs and the textures
-      glBindVertexArray(0);
-      glBindTexture(GL_TEXTURE_2D, 0);
-    }
+void GameObject::render(glm::vec4 colour, int focus, unsigned int layer) {
+  if (this->active) this->snapshot().render(colour, focus, layer);
+}
+
+void ObjectSnapshot::render(glm::vec4 colour, int focus, unsigned int layer) const {
+  GameObjects::Queue->submit(layer, this->transform.position.z, this->texture, this->render_transform, colour, focus);
+
+  // Reveal the collider and the origin of the object on top of everything else
+  if (this->collider_revealed) {
+    glm::vec2 position = glm::vec2(this->transform.position + this->position_offset);
+    DebugDraw::rect(position, this->transform.scale, glm::vec4(0.5f));
+    DebugDraw::rect(position + this->origin, glm::vec2(10.0f), glm::vec4(1.0f, 0.3f, 0.3f, 0.8f));
   }
 }
 
@@ -146,35 +93,44 @@ bool GameObject::check_point_intersection(glm::vec2 point) {
 }
 
 Collision GameObject::check_collision(GameObject *object) {
-  if (object->bounding_box.right >= this->bounding_box.left
-    && object->bounding_box.left <= this->bounding_box.right
-    && object->bounding_box.bottom >= this->bounding_box.top
-    && object->bounding_box.top <= this->bounding_box.bottom
-  ) {
-    glm::vec2 this_center = glm::vec2(this->transform.position + this->position_offset) + (this->transform.scale / glm::vec2(2.0f));
-    glm::vec2 other_half_extent = object->transform.scale / glm::vec2(2.0f);
-    glm::vec2 other_center = glm::vec2(object->transform.position + object->position_offset) + other_half_extent;
-    
-    glm::vec2 clamped = glm::clamp(this->transform.scale, -other_half_extent, other_half_extent);
-    glm::vec2 closest = other_center + clamped;
-    glm::vec2 difference = closest - this_center;
-
-    Direction direction = vector_direction(difference);
-
-    CollisionInfo vertical((object->bounding_box.bottom >= this->bounding_box.top && object->bounding_box.top <= this->bounding_box.bottom));
-    // vertical.collision = (object->bounding_box.bottom >= this->bounding_box.top && object->bounding_box.top <= this->bounding_box.bottom);
-    vertical.direction = vector_direction(glm::vec2(0.0f, difference.y));
-    vertical.mtv = difference.y + (difference.y > 0 ? (this->transform.scale.y / -2.0f) + object->transform.scale.y : (this->transform.scale.y / 2.0f));
-
-    CollisionInfo horizontal((object->bounding_box.right >= this->bounding_box.left && object->bounding_box.left <= this->bounding_box.right));
-    // horizontal.collision = (object->bounding_box.right >= this->bounding_box.left && object->bounding_box.left <= this->bounding_box.right);
-    horizontal.direction = vector_direction(glm::vec2(difference.x, 0.0f));
-    horizontal.mtv = difference.x + (this->transform.scale.x / 2.0f);
-
-    return Collision(true, horizontal, vertical);
+  return Physics::collide(
+    this->bounding_box, glm::vec2(this->transform.position + this->position_offset), this->transform.scale,
+    object->bounding_box, glm::vec2(object->transform.position + object->position_offset), object->transform.scale
+  );
+}
+
+void GameObject::settle() {
+  this->grounded = false;
+
+  std::vector<GameObject *> nearby;
+  GameObjects::query(this->bounding_box, nearby);
+
+  for (GameObject *object : nearby) {
+    // Other dynamic objects are being moved at the same time, so only static rigidbodies are settled against
+    if (object == this || object->dynamic || !object->rigidbody) continue;
+
+    float overlap_x = std::fmin(this->bounding_box.right, object->bounding_box.right) - std::fmax(this->bounding_box.left, object->bounding_box.left);
+    float overlap_y = std::fmin(this->bounding_box.bottom, object->bounding_box.bottom) - std::fmax(this->bounding_box.top, object->bounding_box.top);
+    if (overlap_x <= 0.0f || overlap_y <= 0.0f) continue;
+
+    // Push the object out along whichever axis it is the least deep into the other object
+    if (overlap_x < overlap_y) {
+      bool left_of = this->bounding_box.left + this->bounding_box.right < object->bounding_box.left + object->bounding_box.right;
+      this->transform.position.x += left_of ? -overlap_x : overlap_x;
+      this->velocity.x = 0.0f;
+    } else {
+      bool above = this->bounding_box.top + this->bounding_box.bottom < object->bounding_box.top + object->bounding_box.bottom;
+      this->transform.position.y += above ? -overlap_y : overlap_y;
+      this->velocity.y = 0.0f;
+
+      // The object has landed if it was pushed against the direction it is falling in
+      if (this->acceleration.y != 0.0f && above == (this->acceleration.y < 0.0f)) this->grounded = true;
+    }
+    this->update_bounding_box();
   }
 
-  return Collision();
+  // Keep the resolved position on the fixed-point grid
+  this->transform.position = Physics::quantize(this->transform.position);
 }
 
 void GameObject::update_bounding_box() {
@@ -201,7 +157,7 @@ void GameObject::update_snap_position() {
   new_position.y = std::floor((this->transform.position.y + origin.y) / this->grid.y) * this->grid.y;
 
   // If the new position is outside the dimensions, then just undo any translations and return it to its old position
-  if (new_position.x < 0 || new_position.x > GameObjects::Camera->width - this->grid.x || new_position.y < 0 || new_position.y > GameObjects::Camera->height - this->grid.y) {
+  if (new_position.x < 0 || new_position.x > WorldSize.x - this->grid.x || new_position.y < 0 || new_position.y > WorldSize.y - this->grid.y) {
     this->transform.position = this->old_transform.position;
     this->update_bounding_box();
     return;
@@ -292,8 +248,8 @@ GameObject *GameObjects::create(std::string handle, std::vector<Texture> texture
 
   instantiation_id++;
 
-  Objects[object.id] = object;
-  return &Objects[object.id];
+  Objects[object.id] = new GameObject(object);
+  return Objects[object.id];
 }
 
 GameObject *GameObjects::create(std::string handle, Texture texture, std::vector<std::string> tags, Transform transform) {
@@ -309,8 +265,8 @@ GameObject *GameObjects::instantiate(std::string prefab_handle) {
 
   instantiation_id++;
 
-  Objects[prefab->id] = *prefab;
-  return &Objects[prefab->id];
+  Objects[prefab->id] = new GameObject(*prefab);
+  return Objects[prefab->id];
 }
 
 GameObject *GameObjects::instantiate(GameObject prefab) {
@@ -319,8 +275,8 @@ GameObject *GameObjects::instantiate(GameObject prefab) {
 
   instantiation_id++;
 
-  Objects[prefab.id] = prefab;
-  return &Objects[prefab.id];
+  Objects[prefab.id] = new GameObject(prefab);
+  return Objects[prefab.id];
 }
 
 GameObject *GameObjects::instantiate(std::string prefab_handle, Transform transform) {
@@ -333,15 +289,15 @@ GameObject *GameObjects::instantiate(std::string prefab_handle, Transform transf
   prefab->id = instantiation_id;
   instantiation_id++;
 
-  Objects[prefab->id] = *prefab;
+  Objects[prefab->id] = new GameObject(*prefab);
 
   for (GameObject *&child : prefab->children) {
     GameObject *c = GameObjects::instantiate(*child);
-    c->set_parent(&Objects[prefab->id]);
+    c->set_parent(Objects[prefab->id]);
     c->translate(prefab->transform.position);
   }
 
-  return &Objects[prefab->id];
+  return Objects[prefab->id];
 }
 
 GameObject *GameObjects::instantiate(GameObject prefab, Transform transform) {
@@ -351,19 +307,30 @@ GameObject *GameObjects::instantiate(GameObject prefab, Transform transform) {
   prefab.id = instantiation_id;
   instantiation_id++;
 
-  Objects[prefab.id] = prefab;
-  return &Objects[prefab.id];
+  Objects[prefab.id] = new GameObject(prefab);
+  return Objects[prefab.id];
+}
+
+GameObject *GameObjects::adopt(GameObject *object) {
+  object->id = instantiation_id;
+  object->active = true;
+  instantiation_id++;
+
+  Objects[object->id] = object;
+  return object;
 }
 
 void GameObjects::uninstantiate(std::string handle) {
   for (GameObject *&object : GameObjects::all()) 
     if (object->handle == handle) 
-      Objects.erase(Objects.find(object->id));
+      GameObjects::uninstantiate(object->id);
 }
 
 void GameObjects::uninstantiate(unsigned long id) {
-  if (id <= instantiation_id && Objects.find(id) != Objects.end()) 
+  if (id <= instantiation_id && Objects.find(id) != Objects.end()) {
+    delete Objects[id];
     Objects.erase(id);
+  }
 }
 
 
@@ -372,8 +339,8 @@ std::vector<GameObject *> GameObjects::all() {
 
   // Get all objects if they are active
   for (auto &pair : Objects) {
-    if (pair.second.active) {
-      all_objects.push_back(&pair.second);
+    if (pair.second->active) {
+      all_objects.push_back(pair.second);
     }
   }
   return all_objects;
@@ -382,8 +349,116 @@ std::vector<GameObject *> GameObjects::all() {
 GameObject *GameObjects::get(std::string handle) {
   for (GameObject *&object : GameObjects::all()) {
     if (object->handle == handle)
-      return &Objects[object->id];
+      return object;
   }
+  return nullptr;
+}
+
+void GameObjects::index() {
+  Grid.clear(BoundingBox(0.0f, WorldSize.y, 0.0f, WorldSize.x));
+  SpriteGrid.clear(BoundingBox(0.0f, WorldSize.y, 0.0f, WorldSize.x));
+  Indexed.clear();
+
+  // Characters move every tick, so only the scenery they collide against is indexed
+  for (auto &pair : Objects) {
+    GameObject *object = pair.second;
+    if (!object->active || (object->tags.size() && object->tags[0] == "player")) continue;
+
+    Grid.insert(Indexed.size(), object->bounding_box);
+    SpriteGrid.insert(Indexed.size(), object->render_bounds());
+    Indexed.push_back(object);
+  }
+}
+
+void GameObjects::query(BoundingBox area, std::vector<GameObject *> &out) {
+  std::vector<unsigned int> items;
+  Grid.query(area, items);
+
+  // The items come back sorted, which keeps the objects in the order a full scan would have visited them
+  for (unsigned int item : items) out.push_back(Indexed[item]);
+}
+
+void GameObjects::query_sprites(BoundingBox area, std::vector<GameObject *> &out) {
+  std::vector<unsigned int> items;
+  SpriteGrid.query(area, items);
+  for (unsigned int item : items) out.push_back(Indexed[item]);
+}
+
+// Convert a cast through the grid into a hit on the object it refers to
+static bool to_object_hit(bool found, Physics::Hit &cast, GameObjects::Hit &hit) {
+  if (!found) return false;
+  hit.object = Indexed[cast.item];
+  hit.distance = cast.distance;
+  hit.point = cast.point;
+  hit.normal = cast.normal;
+  return true;
+}
+
+bool GameObjects::raycast(glm::vec2 origin, glm::vec2 direction, float max_distance, Hit &hit, std::function<bool(GameObject *)> filter) {
+  Physics::Hit cast;
+  bool found = Grid.raycast(origin, direction, max_distance, cast, [&](unsigned int item) { return !filter || filter(Indexed[item]); });
+  return to_object_hit(found, cast, hit);
+}
+
+bool GameObjects::segment(glm::vec2 from, glm::vec2 to, Hit &hit, std::function<bool(GameObject *)> filter) {
+  Physics::Hit cast;
+  bool found = Grid.segment(from, to, cast, [&](unsigned int item) { return !filter || filter(Indexed[item]); });
+  return to_object_hit(found, cast, hit);
+}
+
+bool GameObjects::boxcast(BoundingBox box, glm::vec2 direction, float max_distance, Hit &hit, std::function<bool(GameObject *)> filter) {
+  Physics::Hit cast;
+  bool found = Grid.boxcast(box, direction, max_distance, cast, [&](unsigned int item) { return !filter || filter(Indexed[item]); });
+  return to_object_hit(found, cast, hit);
+}
+
+bool GameObjects::grounded(GameObject *object) {
+  return Physics::grounded(Grid, object->bounding_box, object->acceleration.y, [&](unsigned int item) { return Indexed[item] != object && Indexed[item]->rigidbody; });
+}
+
+void GameObjects::integrate() {
+  Dynamic.clear();
+  for (auto &pair : Objects) {
+    GameObject *object = pair.second;
+    if (object->active && object->dynamic && object->rigidbody) Dynamic.push_back(object);
+  }
+  Bodies.resize(Dynamic.size());
+
+  // Each batch of objects is gathered into the component arrays, integrated and scattered back while it is still in cache
+  Jobs::parallel_for(Dynamic.size(), [](unsigned int begin, unsigned int end) {
+    for (unsigned int i = begin; i < end; i++) {
+      GameObject *object = Dynamic[i];
+      Bodies.position_x[i] = object->transform.position.x;
+      Bodies.position_y[i] = object->transform.position.y;
+      Bodies.velocity_x[i] = object->velocity.x;
+      Bodies.velocity_y[i] = object->velocity.y;
+      Bodies.acceleration_x[i] = object->acceleration.x;
+      Bodies.acceleration_y[i] = object->acceleration.y;
+      Bodies.impulse_x[i] = object->impulse.x;
+      Bodies.impulse_y[i] = object->impulse.y;
+      Bodies.drive_x[i] = object->walk_speed;
+      Bodies.grounded[i] = object->grounded;
+    }
+
+    Physics::integrate(Bodies, begin, end);
+
+    for (unsigned int i = begin; i < end; i++) {
+      GameObject *object = Dynamic[i];
+      object->transform.position.x = Bodies.position_x[i];
+      object->transform.position.y = Bodies.position_y[i];
+      object->velocity = glm::vec2(Bodies.velocity_x[i], Bodies.velocity_y[i]);
+      object->impulse = glm::vec2(0.0f);
+      object->update_bounding_box();
+    }
+  });
+
+  // Players resolve their own collisions, as they react to what they touch
+  Jobs::parallel_for(Dynamic.size(), [](unsigned int begin, unsigned int end) {
+    for (unsigned int i = begin; i < end; i++) {
+      if (Dynamic[i]->tags.size() && Dynamic[i]->tags[0] == "player") continue;
+      Dynamic[i]->settle();
+    }
+  });
 }
 
 GameObject *GameObjects::ObjectPrefabs::get(std::string handle) {
@@ -398,16 +473,16 @@ std::vector<GameObject *> GameObjects::filter(std::vector<std::string> tags) {
   // if it doesn't, then just skip that object. Otherwise, add that object to the
   // output vector
   for (auto &pair : Objects) {
-    if (pair.second.active) {
+    if (pair.second->active) {
       bool contains_tags = true;
       for (std::string tag : tags) {
         // If even one of the tag is not found in the GameObject, then ignore the object
-        if (std::find(pair.second.tags.begin(), pair.second.tags.end(), tag) == pair.second.tags.end()) {
+        if (std::find(pair.second->tags.begin(), pair.second->tags.end(), tag) == pair.second->tags.end()) {
           contains_tags = false;
           break;
         }
       }
-      if (contains_tags) filtered_objects.push_back(&pair.second);
+      if (contains_tags) filtered_objects.push_back(pair.second);
     }
   }
   return filtered_objects;
@@ -419,10 +494,10 @@ std::vector<GameObject *> GameObjects::filter(std::string tag) {
   // For each object, if the object is active, check all its tags and if
   // it has the same tag as the one required, then add it to the output vector
   for (auto &pair : Objects) {
-    if (pair.second.active)
-      for (std::string o_tag : pair.second.tags)
+    if (pair.second->active)
+      for (std::string o_tag : pair.second->tags)
         if (tag == o_tag)
-          filtered_objects.push_back(&pair.second);
+          filtered_objects.push_back(pair.second);
   }
   return filtered_objects;
 }
@@ -434,15 +509,15 @@ std::vector<GameObject *> GameObjects::except(std::string tag) {
   // If the tag isn't in linked with the object, then just ignore that object. Otherwise, 
   // add that object to the output vector
   for (auto &pair : Objects) {
-    if (pair.second.active) {
+    if (pair.second->active) {
       bool found = true;
-      for (std::string o_tag : pair.second.tags) {
+      for (std::string o_tag : pair.second->tags) {
         if (tag == o_tag) {
           found = false;
           break;
         }
       }
-      if (found) filtered_objects.push_back(&pair.second);
+      if (found) filtered_objects.push_back(pair.second);
     }
   }
   return filtered_objects;
@@ -697,6 +772,22 @@ void GameObjects::ObjectPrefabs::load_from_file(const char *file_path) {
           if (line == "true") object->rigidbody = true;
           else if (line == "false") object->rigidbody = false;
           else p_error("Invalid syntax at line " + std::to_string(line_num) + " (unknown value)");
+        } else if (substr == "dynamic") {
+          line.erase(0, pos + 1);
+          if (!line.size()) p_error("Invalid syntax at line " + std::to_string(line_num) + " (attribute cannot be empty)");
+
+          if (line == "true") object->dynamic = true;
+          else if (line == "false") object->dynamic = false;
+          else p_error("Invalid syntax at line " + std::to_string(line_num) + " (unknown value)");
+        } else if (substr == "acceleration") {
+          line.erase(0, pos + 1);
+          if (!line.size()) p_error("Invalid syntax at line " + std::to_string(line_num) + " (list cannot be empty)");
+          std::vector<float> acceleration = p_csfloat(line, object);
+          try {
+            object->acceleration = glm::vec2(acceleration[0], acceleration[1]);
+          } catch (...) {
+            p_error("Invalid syntax at line " + std::to_string(line_num) + " (unsufficient parameters)");
+          }
         } else if (substr == "parent") {
           line.erase(0, pos + 1);
           if (!line.size()) p_error("Invalid syntax at line " + std::to_string(line_num) + " (attribute cannot be empty)");
@@ -0,0 +1,98 @@
+#include "parallax.h"
+
+// The layers from back to front, and the shader compositing them
+static std::vector<Parallax::Layer> layers;
+static Shader background_shader;
+
+// The uniforms only the background shader has
+static const UniformId RECTS = Shader::uniform("rects");
+static const UniformId REGIONS = Shader::uniform("regions");
+static const UniformId LAYER_COUNT = Shader::uniform("layer_count");
+
+// The shader draws its quad from the vertex ids alone, but core profiles still need a vertex array bound to draw
+static unsigned int background_vao = 0;
+
+void Parallax::load_from_file(const char *file_path, Shader shader) {
+  std::ifstream file(file_path);
+  std::string line;
+  int line_num = 0;
+
+  layers.clear();
+  background_shader = shader;
+  if (!file.is_open()) printf("[ERROR] Could not open the parallax file %s\n", file_path);
+
+  while (std::getline(file, line)) {
+    line_num++;
+
+    // Erase all spaces, and ignore all comments and blank lines in the file
+    line.erase(std::remove_if(line.begin(), line.end(), [](unsigned char x) { return std::isspace(x); }), line.end());
+    if (line.find("//") == 0 || !line.size()) continue;
+
+    // Parse "<texture-handle>; <distance>; <margin>"
+    std::vector<std::string> fields;
+    std::size_t pos;
+    while ((pos = line.find(";")) != std::string::npos) {
+      fields.push_back(line.substr(0, pos));
+      line.erase(0, pos + 1);
+    }
+    fields.push_back(line);
+
+    if (fields.size() != 3) {
+      printf("[WARNING] Invalid syntax at line %i of %s (expected a texture, a distance and a margin)\n", line_num, file_path);
+      continue;
+    }
+    if (layers.size() == Parallax::MAX_LAYERS) {
+      printf("[WARNING] Too many layers at line %i of %s (at most %u are drawn)\n", line_num, file_path, Parallax::MAX_LAYERS);
+      continue;
+    }
+
+    // The layer is built straight from the fetched texture, in the order of its fields
+    try {
+      Parallax::Layer layer = { ResourceManager::Texture::get(fields[0]), std::stof(fields[1]), std::stof(fields[2]) };
+
+      // The frames of animations live in array textures, which the shader does not sample
+      if (layer.texture.target != GL_TEXTURE_2D) {
+        printf("[WARNING] The texture %s at line %i of %s is an animation frame, which cannot be a parallax layer\n", fields[0].c_str(), line_num, file_path);
+        continue;
+      }
+
+      layers.push_back(layer);
+    } catch (...) {
+      printf("[WARNING] Invalid layer at line %i of %s\n", line_num, file_path);
+    }
+  }
+
+  // Every layer samples the texture unit matching its index
+  background_shader.activate();
+  for (unsigned int i = 0; i < Parallax::MAX_LAYERS; i++) background_shader.set_integer(("layer" + std::to_string(i)).c_str(), i);
+}
+
+void Parallax::render(glm::vec2 mouse_position, glm::vec2 screen_size) {
+  if (layers.empty()) return;
+  if (background_vao == 0) glGenVertexArrays(1, &background_vao);
+
+  // Work out where every layer is, packing the rectangles and the texture regions into the columns of two matrices
+  glm::mat4 rects = glm::mat4(0.0f), regions = glm::mat4(0.0f);
+  for (unsigned int i = 0; i < layers.size(); i++) {
+    const Parallax::Layer &layer = layers[i];
+    glm::vec2 offset = (layer.distance > 0.0f) ? mouse_position / glm::vec2(layer.distance) : glm::vec2(0.0f);
+    rects[i] = glm::vec4(offset - glm::vec2(layer.margin), screen_size + glm::vec2(Parallax::OVERSCAN));
+    regions[i] = layer.texture.uv;
+    GLState::bind_texture(i, GL_TEXTURE_2D, layer.texture.id);
+  }
+
+  background_shader.activate();
+  background_shader.set_matrix_4f(Uniforms::MODEL, glm::scale(glm::mat4(1.0f), glm::vec3(screen_size, 1.0f)));
+  background_shader.set_matrix_4f(RECTS, rects);
+  background_shader.set_matrix_4f(REGIONS, regions);
+  background_shader.set_integer(LAYER_COUNT, layers.size());
+
+  // The shader already multiplied its colours by their alpha
+  GLState::blend(true, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+  GLState::bind_vertex_array(background_vao);
+  glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+  GLState::blend(true);
+
+  RenderStats::draw_calls++;
+  RenderStats::fill += (unsigned long)(screen_size.x * screen_size.y);
+}
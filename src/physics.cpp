@@ -21,3 +21,246 @@ Direction vector_direction(glm::vec2 target) {
 
   return (Direction)match;
 }
+
+Collision Physics::collide(BoundingBox box, glm::vec2 position, glm::vec2 scale, BoundingBox other_box, glm::vec2 other_position, glm::vec2 other_scale) {
+  if (other_box.right >= box.left
+    && other_box.left <= box.right
+    && other_box.bottom >= box.top
+    && other_box.top <= box.bottom
+  ) {
+    glm::vec2 center = position + (scale / glm::vec2(2.0f));
+    glm::vec2 other_half_extent = other_scale / glm::vec2(2.0f);
+    glm::vec2 other_center = other_position + other_half_extent;
+
+    glm::vec2 clamped = glm::clamp(scale, -other_half_extent, other_half_extent);
+    glm::vec2 closest = other_center + clamped;
+    glm::vec2 difference = closest - center;
+
+    CollisionInfo vertical((other_box.bottom >= box.top && other_box.top <= box.bottom));
+    vertical.direction = vector_direction(glm::vec2(0.0f, difference.y));
+    vertical.mtv = Physics::quantize(difference.y + (difference.y > 0 ? (scale.y / -2.0f) + other_scale.y : (scale.y / 2.0f)));
+
+    CollisionInfo horizontal((other_box.right >= box.left && other_box.left <= box.right));
+    horizontal.direction = vector_direction(glm::vec2(difference.x, 0.0f));
+    horizontal.mtv = Physics::quantize(difference.x + (scale.x / 2.0f));
+
+    return Collision(true, horizontal, vertical);
+  }
+
+  return Collision();
+}
+
+bool Physics::deterministic = false;
+unsigned long Physics::tick_count = 0;
+uint64_t Physics::checksum = Physics::CHECKSUM_SEED;
+bool Physics::trace_checksums = false;
+
+float Physics::quantize(float value) {
+  if (!Physics::deterministic) return value;
+  return Physics::to_float(Physics::to_fixed(value));
+}
+
+glm::vec2 Physics::quantize(glm::vec2 value) {
+  return glm::vec2(Physics::quantize(value.x), Physics::quantize(value.y));
+}
+
+glm::vec3 Physics::quantize(glm::vec3 value) {
+  return glm::vec3(Physics::quantize(value.x), Physics::quantize(value.y), Physics::quantize(value.z));
+}
+
+uint64_t Physics::hash(uint64_t checksum, fixed value) {
+  // Hash the value byte by byte so the checksum does not depend on the host's endianness
+  uint32_t bits = (uint32_t)value;
+  for (int i = 0; i < 4; i++) {
+    checksum ^= (bits >> (i * 8)) & 0xff;
+    checksum *= 0x100000001b3ULL;
+  }
+  return checksum;
+}
+
+void Physics::SpatialGrid::clear(BoundingBox area) {
+  this->area = area;
+  this->columns = std::max(1, (int)std::ceil((area.right - area.left) / this->cell_size));
+  this->rows = std::max(1, (int)std::ceil((area.bottom - area.top) / this->cell_size));
+
+  // Keep the memory of the cells around, as the grid is usually refilled with a similar number of items
+  this->cells.resize(this->columns * this->rows);
+  for (std::vector<unsigned int> &cell : this->cells) cell.clear();
+  this->boxes.clear();
+}
+
+void Physics::SpatialGrid::cell_range(BoundingBox box, int &left, int &top, int &right, int &bottom) const {
+  left = std::clamp((int)std::floor((box.left - this->area.left) / this->cell_size), 0, this->columns - 1);
+  right = std::clamp((int)std::floor((box.right - this->area.left) / this->cell_size), 0, this->columns - 1);
+  top = std::clamp((int)std::floor((box.top - this->area.top) / this->cell_size), 0, this->rows - 1);
+  bottom = std::clamp((int)std::floor((box.bottom - this->area.top) / this->cell_size), 0, this->rows - 1);
+}
+
+void Physics::SpatialGrid::insert(unsigned int item, BoundingBox box) {
+  int left, top, right, bottom;
+  this->cell_range(box, left, top, right, bottom);
+
+  if (item >= this->boxes.size()) this->boxes.resize(item + 1);
+  this->boxes[item] = box;
+
+  for (int y = top; y <= bottom; y++)
+    for (int x = left; x <= right; x++)
+      this->cells[y * this->columns + x].push_back(item);
+}
+
+void Physics::SpatialGrid::query(BoundingBox box, std::vector<unsigned int> &out) const {
+  if (this->cells.empty()) return;
+
+  int left, top, right, bottom;
+  this->cell_range(box, left, top, right, bottom);
+
+  // Items spanning several cells are found once per cell, so sort and remove the duplicates
+  std::size_t start = out.size();
+  for (int y = top; y <= bottom; y++)
+    for (int x = left; x <= right; x++)
+      out.insert(out.end(), this->cells[y * this->columns + x].begin(), this->cells[y * this->columns + x].end());
+
+  std::sort(out.begin() + start, out.end());
+  out.erase(std::unique(out.begin() + start, out.end()), out.end());
+}
+
+void Physics::Bodies::resize(unsigned int size) {
+  this->position_x.resize(size);
+  this->position_y.resize(size);
+  this->velocity_x.resize(size);
+  this->velocity_y.resize(size);
+  this->acceleration_x.resize(size);
+  this->acceleration_y.resize(size);
+  this->impulse_x.resize(size);
+  this->impulse_y.resize(size);
+  this->drive_x.resize(size);
+  this->grounded.resize(size);
+}
+
+void Physics::integrate(Bodies &bodies, unsigned int begin, unsigned int end) {
+  // Accumulate the velocities first. This loop has no branches, so the compiler is free to vectorise it.
+  for (unsigned int i = begin; i < end; i++) {
+    bodies.velocity_x[i] += bodies.acceleration_x[i] + bodies.impulse_x[i];
+    bodies.velocity_y[i] = (bodies.grounded[i] ? 0.0f : bodies.velocity_y[i]) + bodies.acceleration_y[i] + bodies.impulse_y[i];
+    bodies.impulse_x[i] = 0.0f;
+    bodies.impulse_y[i] = 0.0f;
+  }
+
+  // Integrate in fixed-point, dividing by the tick rate instead of multiplying by the (inexact) tick length
+  if (Physics::deterministic) {
+    for (unsigned int i = begin; i < end; i++) {
+      bodies.velocity_x[i] = Physics::quantize(bodies.velocity_x[i]);
+      bodies.velocity_y[i] = Physics::quantize(bodies.velocity_y[i]);
+
+      Physics::fixed dx = Physics::divide(Physics::to_fixed(bodies.velocity_x[i] + bodies.drive_x[i]), Physics::TICK_RATE);
+      Physics::fixed dy = Physics::divide(Physics::to_fixed(-bodies.velocity_y[i]), Physics::TICK_RATE);
+      bodies.position_x[i] = Physics::to_float(Physics::to_fixed(bodies.position_x[i]) + dx);
+      bodies.position_y[i] = Physics::to_float(Physics::to_fixed(bodies.position_y[i]) + dy);
+    }
+    return;
+  }
+
+  // Flip the y-component of the velocity, as positions grow downwards
+  const float tick = (float)Physics::TICK;
+  for (unsigned int i = begin; i < end; i++) {
+    bodies.position_x[i] += (bodies.velocity_x[i] + bodies.drive_x[i]) * tick;
+    bodies.position_y[i] -= bodies.velocity_y[i] * tick;
+  }
+}
+
+// Sweep a box, given by its top-left corner and size, along a (normalised) direction against another box.
+// Returns false if the sweep misses, or if it starts inside of the other box.
+static bool sweep(glm::vec2 start, glm::vec2 size, glm::vec2 direction, BoundingBox box, float &distance, glm::vec2 &normal) {
+  // Grow the other box by the size of the swept box, so that only the swept box's corner has to be traced
+  glm::vec2 low = glm::vec2(box.left - size.x, box.top - size.y);
+  glm::vec2 high = glm::vec2(box.right, box.bottom);
+
+  float entry = -std::numeric_limits<float>::infinity();
+  float exit = std::numeric_limits<float>::infinity();
+  int axis = -1;
+  for (int i = 0; i < 2; i++) {
+    if (direction[i] == 0.0f) {
+      if (start[i] <= low[i] || start[i] >= high[i]) return false;
+      continue;
+    }
+
+    float near = (low[i] - start[i]) / direction[i];
+    float far = (high[i] - start[i]) / direction[i];
+    if (near > far) std::swap(near, far);
+    if (near > entry) {
+      entry = near;
+      axis = i;
+    }
+    exit = std::fmin(exit, far);
+  }
+
+  if (axis < 0 || entry > exit || entry < 0.0f) return false;
+
+  distance = entry;
+  normal = glm::vec2(0.0f);
+  normal[axis] = direction[axis] > 0.0f ? -1.0f : 1.0f;
+  return true;
+}
+
+bool Physics::SpatialGrid::raycast(glm::vec2 origin, glm::vec2 direction, float max_distance, Hit &hit, const std::function<bool(unsigned int)> &filter) const {
+  return this->boxcast(BoundingBox(origin.y, origin.y, origin.x, origin.x), direction, max_distance, hit, filter);
+}
+
+bool Physics::SpatialGrid::segment(glm::vec2 from, glm::vec2 to, Hit &hit, const std::function<bool(unsigned int)> &filter) const {
+  return this->raycast(from, to - from, glm::length(to - from), hit, filter);
+}
+
+bool Physics::SpatialGrid::boxcast(BoundingBox box, glm::vec2 direction, float max_distance, Hit &hit, const std::function<bool(unsigned int)> &filter) const {
+  float length = glm::length(direction);
+  if (this->cells.empty() || length == 0.0f) return false;
+  direction /= length;
+
+  // Nothing can be hit once the cast has left the grid, so there is no point in sweeping any further than across it
+  glm::vec2 start = glm::vec2(box.left, box.top);
+  glm::vec2 size = glm::vec2(box.right - box.left, box.bottom - box.top);
+  float across = glm::length(glm::vec2(this->area.right - this->area.left, this->area.bottom - this->area.top)) + size.x + size.y;
+  max_distance = std::fmin(max_distance, across);
+
+  // Sweep the box one cell at a time. Anything hit before the end of a slice overlaps the cells that slice covers,
+  // so as soon as the closest hit so far lies within the slices swept already, nothing further along can beat it.
+  bool found = false;
+  std::vector<unsigned int> candidates;
+  for (float near = 0.0f; near <= max_distance; near += this->cell_size) {
+    float far = std::fmin(near + this->cell_size, max_distance);
+    glm::vec2 from = start + direction * near;
+    glm::vec2 to = start + direction * far;
+
+    candidates.clear();
+    this->query(BoundingBox(std::fmin(from.y, to.y), std::fmax(from.y, to.y) + size.y, std::fmin(from.x, to.x), std::fmax(from.x, to.x) + size.x), candidates);
+
+    for (unsigned int item : candidates) {
+      if (filter && !filter(item)) continue;
+
+      float distance;
+      glm::vec2 normal;
+      if (!sweep(start, size, direction, this->boxes[item], distance, normal)) continue;
+      if (distance > max_distance || (found && distance >= hit.distance)) continue;
+
+      found = true;
+      hit.item = item;
+      hit.distance = distance;
+      hit.normal = normal;
+    }
+
+    if ((found && hit.distance <= far) || far >= max_distance) break;
+  }
+
+  if (found) hit.point = start + size / 2.0f + direction * hit.distance;
+  return found;
+}
+
+bool Physics::grounded(const SpatialGrid &grid, BoundingBox box, float gravity, const std::function<bool(unsigned int)> &filter) {
+  if (gravity == 0.0f) return false;
+
+  // The skin is kept within the body, so a short body does not look for the ground above its own head
+  float skin = std::fmin(Physics::GROUND_SKIN, (box.bottom - box.top) / 2.0f);
+  float feet = (gravity < 0.0f) ? box.bottom - skin : box.top + skin;
+
+  Physics::Hit hit;
+  return grid.boxcast(BoundingBox(feet, feet, box.left, box.right), glm::vec2(0.0f, gravity < 0.0f ? 1.0f : -1.0f), skin + Physics::GROUND_PROBE, hit, filter);
+}
@@ -1,24 +1,28 @@
 #include "player.h"
 
+std::vector<Player *> Characters::Players::Players;
+Player *Characters::Players::ActivePlayer = nullptr;
+
 Player *Characters::Players::create(const char *handle, std::vector<Texture> texture, Transform transform, std::vector<std::string> tags) {
-  Player player = Player();
-  player.handle = handle;
-  player.texture = texture;
-  player.tags = tags;
-  player.transform = transform;
-  player.rigidbody = true;
-  player.update_bounding_box();
-
-  Characters::Players::Players[handle] = player;
-  return &Characters::Players::Players[handle];
+  Player *player = new Player();
+  player->handle = handle;
+  player->texture = texture;
+  player->tags = tags;
+  player->transform = transform;
+  player->rigidbody = true;
+  player->update_bounding_box();
+
+  GameObjects::adopt(player);
+  Characters::Players::Players.push_back(player);
+  return player;
 }
 
 Player *Characters::Players::create(const char *handle, Texture texture, Transform transform, std::vector<std::string> tags) {
   return Characters::Players::create(handle, (std::vector<Texture>){ texture }, transform, tags);
 }
 
-void Player::animate() {
-  this->animation_timer -= Time::delta * 1000;
+void Player::animate(double delta) {
+  this->animation_timer -= delta * 1000;
 
   if (this->animation_timer <= 0.0f) {
     this->texture_index = (this->texture_index + 1) % this->texture.size();
@@ -29,108 +33,136 @@ void Player::animate() {
 
 void Player::update() {
   if (this->rigidbody) {
-    if (this->bounding_box.left <= 0.0f || this->bounding_box.right >= GameObjects::Camera->width) {
+    if (this->bounding_box.left <= 0.0f || this->bounding_box.right >= WorldSize.x) {
       this->walk_speed *= -1;
       
       if (this->walk_speed < 0) this->flip_x = true;
       else this->flip_x = false;
 
-      this->transform.position.x = std::clamp(this->transform.position.x - this->position_offset.x, 0.0f, (float)GameObjects::Camera->width - this->transform.scale.x);
+      this->transform.position.x = std::clamp(this->transform.position.x - this->position_offset.x, 0.0f, WorldSize.x - this->transform.scale.x);
     }
   }
   this->transform.position.z = 1.0f;
 }
 
-void Player::resolve_vectors() {
-  // If the object is grounded, nullify the y-velocity.
-  // This is done to allow inversing gravity even when the player is grounded.
-  if (this->grounded) this->velocity.y = 0.0f;
-
-  // Apply impulse acceleration and regular acceleration to the object
-  this->velocity.x += this->acceleration.x;
-  this->velocity.x += this->impulse.x;
-
-  this->velocity.y += this->acceleration.y;
-  this->velocity.y += this->impulse.y;
-
-  // Flip the y-component of the velocity as it points upwards, which is incorrect in this context
-  this->transform.position += glm::vec3((this->velocity.x + this->walk_speed) * Time::delta, -this->velocity.y * Time::delta, 0.0f);
-  this->impulse = glm::vec2(0.0f);
-
-  // Update the bounding box of the player
-  this->update_bounding_box();
-}
-
 void Player::resolve_collisions() {
   if (!this->rigidbody) return;
 
   // Set variables to false, so if they are not updated, they will be false by default
-  this->grounded = false;
+  bool landed = false;
   this->won = false;
+  this->goal = nullptr;
+  this->contacts.clear();
 
   // Only do collisions if a parent tile is set. If no parent tile exist, then the player is not colliding
-  // with any tiles, and running collisions is redundant
-  if (this->parent != nullptr) {
-    int t_touching = 0;
-    for (GameObject *&object : GameObjects::all()) {
-      // The collision is being checked here as it is needed for the lock-unlock calculation
-      Collision collision = object->check_collision(this);
-
-      // If the object is a rigidbody, then execute the collision checking
-      if (object->rigidbody) {
-        if (collision) {
-          if (collision.vertical && collision.vertical.direction == DOWN) {
-            this->grounded = true;
-            this->transform.position.y -= collision.vertical.mtv;
-          } else if (collision.vertical && collision.vertical.direction == UP && !this->grounded) {
-            this->grounded = false;
-            this->transform.position.y -= collision.vertical.mtv - object->transform.scale.y - this->transform.scale.y - 20.0f;
-            this->velocity.y = 0.0f;
-          } 
-
-          if (object->tags[0] == "obstacle") {
-            if (object->tags[1] == "obstacle-safe") {
-              if (collision.vertical && collision.vertical.direction == DOWN) this->transform.position.y -= collision.vertical.mtv;
-              else {
-                if (collision.horizontal && collision.horizontal.direction == LEFT) this->transform.position.x -= collision.horizontal.mtv;
-                else if (collision.horizontal && collision.horizontal.direction == RIGHT) this->transform.position.x -= collision.horizontal.mtv - object->transform.scale.x - this->transform.scale.x;
-                this->walk_speed *= -1.0;
-
-                if (this->walk_speed < 0) this->flip_x = true;
-                else this->flip_x = false;
-              }
-            } else if (object->tags[1] == "obstacle-danger") {
-              this->die = true;
-            }
-          }
-        }
-      } 
+  // with any tiles, and running collisions is redundant. Walkers are never given a parent, so they always run them.
+  bool resolve = this->parent != nullptr || this != Characters::Players::ActivePlayer;
+
+  // Only the objects the spatial index finds near the player can be touching it
+  std::vector<GameObject *> nearby;
+  GameObjects::query(this->bounding_box, nearby);
+
+  for (GameObject *&object : nearby) {
+    // Every collision is checked exactly once per tick, and cached as a contact for anything else that needs it.
+    // This happens even without a parent tile, as the parent tile is picked from the tiles among the contacts.
+    Collision collision = object->check_collision(this);
+    if (!collision) continue;
+    this->contacts.push_back(Contact(object, collision));
+    if (!resolve) continue;
+
+    // If the object is a rigidbody, then push the player out of it
+    if (object->rigidbody) {
+      if (collision.vertical && collision.vertical.direction == DOWN) {
+        landed = true;
+        this->transform.position.y -= collision.vertical.mtv;
+      } else if (collision.vertical && collision.vertical.direction == UP && !landed) {
+        this->transform.position.y -= collision.vertical.mtv - object->transform.scale.y - this->transform.scale.y - 20.0f;
+        this->velocity.y = 0.0f;
+      }
+
+      if (object->tags[0] == "obstacle" && object->tags[1] == "obstacle-safe") {
+        if (collision.vertical && collision.vertical.direction == DOWN) this->transform.position.y -= collision.vertical.mtv;
+        else {
+          if (collision.horizontal && collision.horizontal.direction == LEFT) this->transform.position.x -= collision.horizontal.mtv;
+          else if (collision.horizontal && collision.horizontal.direction == RIGHT) this->transform.position.x -= collision.horizontal.mtv - object->transform.scale.x - this->transform.scale.x;
+          this->walk_speed *= -1.0;
 
-      if (collision && !object->rigidbody) {
-        if (object->tags[0] == "tile") {
-          t_touching++;
+          if (this->walk_speed < 0) this->flip_x = true;
+          else this->flip_x = false;
         }
       }
+    }
+  }
+
+  // React to everything the player touched during this tick
+  if (resolve) {
+    int t_touching = 0;
+    for (Contact &contact : this->contacts) {
+      GameObject *object = contact.object;
+      if (object->rigidbody && object->tags[0] == "obstacle" && object->tags[1] == "obstacle-danger") this->die = true;
+      if (!object->rigidbody && object->tags[0] == "tile") t_touching++;
 
-      if (collision && object->tags[0] == "goal") {
-        object->texture_index = 1;
+      if (object->tags[0] == "goal") {
+        this->goal = object;
         this->won = true;
-        this->locked = true;
       }
     }
 
-    if (t_touching >= 2) {
-      this->locked = true;
-    } else {
-      this->locked = false;
-    }
+    // The player cannot be moved while it is standing between two tiles
+    this->locked = t_touching >= 2;
   }
+
+  // Keep the resolved position on the fixed-point grid
+  this->transform.position = Physics::quantize(this->transform.position);
+  this->update_bounding_box();
+
+  // Now that the player has been pushed out of everything, it is grounded if there is a rigidbody right below its feet
+  this->grounded = resolve && GameObjects::grounded(this);
+}
+
+bool Player::touching(GameObject *object) {
+  for (Contact &contact : this->contacts)
+    if (contact.object == object) return true;
+  return false;
 }
 
 std::vector<Player *> Characters::Players::all() {
   std::vector<Player *> all_players;
-  for (auto &pair : Characters::Players::Players)
-    if (pair.second.active)
-      all_players.push_back(&pair.second);
+  for (Player *player : Characters::Players::Players)
+    if (player->active)
+      all_players.push_back(player);
   return all_players;
 }
+
+void Characters::Players::clear() {
+  std::vector<Player *> kept;
+  for (Player *player : Characters::Players::Players) {
+    if (player == Characters::Players::ActivePlayer) kept.push_back(player);
+    else GameObjects::uninstantiate(player->id);
+  }
+  Characters::Players::Players = kept;
+}
+
+void Characters::Players::step(bool paused) {
+  std::vector<Player *> players = Characters::Players::all();
+
+  if (paused) {
+    Jobs::parallel_for(players.size(), [&](unsigned int begin, unsigned int end) {
+      for (unsigned int i = begin; i < end; i++) players[i]->update();
+    });
+    return;
+  }
+
+  // Each stage only writes to the player it is processing, so the players can be split across threads
+  Jobs::parallel_for(players.size(), [&](unsigned int begin, unsigned int end) {
+    for (unsigned int i = begin; i < end; i++) players[i]->update();
+  });
+  Jobs::parallel_for(players.size(), [&](unsigned int begin, unsigned int end) {
+    for (unsigned int i = begin; i < end; i++) players[i]->resolve_collisions();
+  });
+
+  // Effects on other objects are applied afterwards, as several players may have touched the same object
+  for (Player *player : players) {
+    if (player->goal != nullptr) player->goal->texture_index = 1;
+  }
+}
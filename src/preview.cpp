@@ -0,0 +1,213 @@
+#include "preview.h"
+
+// The vertex array the path is drawn with, created the first time a path is drawn
+static unsigned int path_vao = 0;
+
+void Preview::clone(World &world, Player *player, GameObject *dragged) {
+  // Work out where the dragged object would land, the same way the drop is resolved in Game::update
+  GameObject *swapped = nullptr;
+  glm::vec2 dragged_position = glm::vec2(0.0f), swapped_position = glm::vec2(0.0f);
+  if (dragged != nullptr) {
+    dragged_position = glm::vec2(dragged->old_transform.position);
+
+    if (dragged->grid.x > 0.0f && dragged->grid.y > 0.0f) {
+      glm::vec2 target = glm::floor((glm::vec2(dragged->transform.position) + dragged->origin) / dragged->grid) * dragged->grid;
+      if (target.x >= 0 && target.x <= WorldSize.x - dragged->grid.x && target.y >= 0 && target.y <= WorldSize.y - dragged->grid.y) {
+        dragged_position = target;
+
+        // Dropping onto another swappable object swaps the two, unless the other one is locked
+        if (dragged->swap) {
+          for (GameObject *&object : GameObjects::all()) {
+            if (object == dragged || !object->swap) continue;
+            if ((int)object->transform.position.x != (int)target.x || (int)object->transform.position.y != (int)target.y) continue;
+
+            if (object->locked) dragged_position = glm::vec2(dragged->old_transform.position);
+            else {
+              swapped = object;
+              swapped_position = glm::vec2(dragged->old_transform.position);
+            }
+            break;
+          }
+        }
+      }
+    }
+  }
+
+  // Copy every collider, moving the dragged and swapped objects (and their children) to where they would end up
+  world.colliders.clear();
+  world.size = WorldSize;
+  world.grid.clear(BoundingBox(0.0f, WorldSize.y, 0.0f, WorldSize.x));
+  for (GameObject *&object : GameObjects::all()) {
+    if (object->tags.size() && object->tags[0] == "player") continue;
+
+    Collider collider;
+    collider.scale = object->transform.scale;
+    collider.rigidbody = object->rigidbody;
+
+    bool moved = false;
+    if (dragged != nullptr && (object == dragged || object->parent == dragged)) {
+      collider.position = dragged_position + glm::vec2(object->position_offset);
+      moved = true;
+
+      // Dropped children become rigidbodies again, unless they are a goal
+      if (object != dragged && object->handle != "goal") collider.rigidbody = true;
+    } else if (swapped != nullptr && (object == swapped || object->parent == swapped)) {
+      collider.position = swapped_position + glm::vec2(object->position_offset);
+      moved = true;
+    } else {
+      collider.position = glm::vec2(object->transform.position + object->position_offset);
+    }
+
+    if (moved) collider.bounding_box = BoundingBox(collider.position.y, collider.position.y + collider.scale.y, collider.position.x, collider.position.x + collider.scale.x);
+    else collider.bounding_box = object->bounding_box;
+
+    collider.kind = COLLIDER_OTHER;
+    if (object->tags.size()) {
+      if (object->tags[0] == "tile") collider.kind = COLLIDER_TILE;
+      else if (object->tags[0] == "goal") collider.kind = COLLIDER_GOAL;
+      else if (object->tags[0] == "obstacle" && object->tags.size() > 1) {
+        if (object->tags[1] == "obstacle-safe") collider.kind = COLLIDER_SAFE;
+        else if (object->tags[1] == "obstacle-danger") collider.kind = COLLIDER_DANGER;
+      }
+    }
+
+    world.grid.insert(world.colliders.size(), collider.bounding_box);
+    world.colliders.push_back(collider);
+  }
+
+  // The player rides along with whichever of the two tiles it is standing in
+  Walker &walker = world.walker;
+  if (dragged != nullptr && player->parent == dragged) {
+    walker.position = dragged_position + glm::vec2(player->position_offset);
+  } else if (swapped != nullptr && player->parent == swapped) {
+    walker.position = swapped_position + glm::vec2(std::fmod(player->transform.position.x, swapped->grid.x), std::fmod(player->transform.position.y, swapped->grid.y));
+  } else {
+    walker.position = glm::vec2(player->transform.position + player->position_offset);
+  }
+  walker.scale = player->transform.scale;
+  walker.bounding_box = BoundingBox(walker.position.y, walker.position.y + walker.scale.y, walker.position.x, walker.position.x + walker.scale.x);
+  walker.grounded = player->grounded;
+  walker.won = player->won;
+  walker.die = player->die;
+
+  Physics::Bodies &body = world.body;
+  body.resize(1);
+  body.velocity_x[0] = player->velocity.x;
+  body.velocity_y[0] = player->velocity.y;
+  body.acceleration_x[0] = player->acceleration.x;
+  body.acceleration_y[0] = player->acceleration.y;
+  body.impulse_x[0] = player->impulse.x;
+  body.impulse_y[0] = player->impulse.y;
+  body.drive_x[0] = player->walk_speed;
+}
+
+bool Preview::step(World &world) {
+  Walker &walker = world.walker;
+  Physics::Bodies &body = world.body;
+  if (walker.won || walker.die) return false;
+
+  // Integrate the walker with the very same integrator the real players go through
+  body.position_x[0] = walker.position.x;
+  body.position_y[0] = walker.position.y;
+  body.grounded[0] = walker.grounded;
+  Physics::integrate(body, 0, 1);
+  walker.position = glm::vec2(body.position_x[0], body.position_y[0]);
+  walker.bounding_box = BoundingBox(walker.position.y, walker.position.y + walker.scale.y, walker.position.x, walker.position.x + walker.scale.x);
+
+  // Turn around at the edges of the world
+  if (walker.bounding_box.left <= 0.0f || walker.bounding_box.right >= world.size.x) {
+    body.drive_x[0] *= -1;
+    walker.position.x = std::clamp(walker.position.x, 0.0f, world.size.x - walker.scale.x);
+  }
+
+  bool landed = false;
+  walker.won = false;
+
+  world.nearby.clear();
+  world.grid.query(walker.bounding_box, world.nearby);
+
+  for (unsigned int item : world.nearby) {
+    Collider &collider = world.colliders[item];
+    Collision collision = Physics::collide(collider.bounding_box, collider.position, collider.scale, walker.bounding_box, walker.position, walker.scale);
+    if (!collision) continue;
+
+    if (collider.rigidbody) {
+      if (collision.vertical && collision.vertical.direction == DOWN) {
+        landed = true;
+        walker.position.y -= collision.vertical.mtv;
+      } else if (collision.vertical && collision.vertical.direction == UP && !landed) {
+        walker.position.y -= collision.vertical.mtv - collider.scale.y - walker.scale.y - 20.0f;
+        body.velocity_y[0] = 0.0f;
+      }
+
+      if (collider.kind == COLLIDER_SAFE) {
+        if (collision.vertical && collision.vertical.direction == DOWN) walker.position.y -= collision.vertical.mtv;
+        else {
+          if (collision.horizontal && collision.horizontal.direction == LEFT) walker.position.x -= collision.horizontal.mtv;
+          else if (collision.horizontal && collision.horizontal.direction == RIGHT) walker.position.x -= collision.horizontal.mtv - collider.scale.x - walker.scale.x;
+          body.drive_x[0] *= -1.0;
+        }
+      } else if (collider.kind == COLLIDER_DANGER) {
+        walker.die = true;
+      }
+    }
+
+    if (collider.kind == COLLIDER_GOAL) walker.won = true;
+  }
+
+  walker.position = Physics::quantize(walker.position);
+  walker.bounding_box = BoundingBox(walker.position.y, walker.position.y + walker.scale.y, walker.position.x, walker.position.x + walker.scale.x);
+  walker.grounded = Physics::grounded(world.grid, walker.bounding_box, body.acceleration_y[0], [&](unsigned int item) { return world.colliders[item].rigidbody; });
+
+  return !walker.won && !walker.die;
+}
+
+void Preview::simulate(World &world, unsigned int ticks, std::vector<glm::vec2> &path) {
+  path.clear();
+  path.push_back(world.walker.position + world.walker.scale / 2.0f);
+
+  for (unsigned int i = 0; i < ticks; i++) {
+    bool moving = Preview::step(world);
+    path.push_back(world.walker.position + world.walker.scale / 2.0f);
+    if (!moving) break;
+  }
+}
+
+void Preview::render(const std::vector<glm::vec2> &path, glm::vec4 colour) {
+  if (path.size() < 2) return;
+
+  if (path_vao == 0) {
+    glGenVertexArrays(1, &path_vao);
+    GLState::bind_vertex_array(path_vao);
+    GLState::bind_buffer(GL_ARRAY_BUFFER, StreamBuffer::id());
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), 0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void *)(2 * sizeof(float)));
+    GLState::bind_buffer(GL_ARRAY_BUFFER, 0);
+    GLState::bind_vertex_array(0);
+  }
+
+  // Sample the middle of the blank texture, so the line is a flat colour without the sprite border highlight
+  std::vector<float> vertices;
+  vertices.reserve(path.size() * 4);
+  for (const glm::vec2 &point : path) {
+    vertices.push_back(point.x);
+    vertices.push_back(point.y);
+    vertices.push_back(0.5f);
+    vertices.push_back(0.5f);
+  }
+
+  unsigned int first = StreamBuffer::write(vertices.data(), sizeof(float) * vertices.size(), sizeof(float) * 4);
+
+  Shader shader = ResourceManager::Shader::get("default");
+  shader.activate();
+  shader.set_vector_4f(Uniforms::COLOUR, colour);
+  shader.set_integer(Uniforms::FOCUS, 0);
+  shader.set_matrix_4f(Uniforms::MODEL, glm::mat4(1.0f));
+  GLState::bind_texture(0, GL_TEXTURE_2D, ResourceManager::Texture::get("blank").id);
+
+  GLState::bind_vertex_array(path_vao);
+  glDrawArrays(GL_LINE_STRIP, first, path.size());
+  RenderStats::draw_calls++;
+}
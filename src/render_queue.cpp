@@ -0,0 +1,71 @@
+#include "render_queue.h"
+
+uint64_t RenderQueue::key(unsigned int layer, float depth, unsigned int shader, unsigned int texture) {
+  // Flip the bits of the depth so that comparing them as unsigned integers orders them like the floats they are
+  uint32_t bits;
+  std::memcpy(&bits, &depth, sizeof(bits));
+  bits = (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+
+  uint64_t key = (uint64_t)(layer & ((1u << LAYER_BITS) - 1));
+  key = (key << DEPTH_BITS) | (bits >> (32 - DEPTH_BITS));
+  key = (key << SHADER_BITS) | (shader & ((1u << SHADER_BITS) - 1));
+  key = (key << TEXTURE_BITS) | (texture & ((1u << TEXTURE_BITS) - 1));
+  return key;
+}
+
+RenderQueue::RenderQueue(SpriteBatch *batch, unsigned int shader) {
+  this->batch = batch;
+  this->shader = shader;
+}
+
+void RenderQueue::submit(unsigned int layer, float depth, Texture texture, Transform transform, glm::vec4 colour, int focus) {
+  this->entries.push_back({ RenderQueue::key(layer, depth, this->shader, texture.id), (unsigned int)this->sprites.size(), false });
+  this->sprites.push_back({ 0, texture, transform, colour, focus });
+}
+
+void RenderQueue::submit(unsigned int layer, float depth, unsigned int shader, std::function<void()> draw) {
+  this->entries.push_back({ RenderQueue::key(layer, depth, shader, 0), (unsigned int)this->draws.size(), true });
+  this->draws.push_back(draw);
+}
+
+void RenderQueue::sort() {
+  this->scratch.resize(this->entries.size());
+
+  for (int shift = 0; shift < 64; shift += 8) {
+    unsigned int offsets[256] = { 0 };
+    for (const Entry &entry : this->entries) offsets[(entry.key >> shift) & 0xff]++;
+
+    // Most bytes of the key are the same for every item (like the shader), in which case the pass can be skipped
+    if (offsets[(this->entries[0].key >> shift) & 0xff] == this->entries.size()) continue;
+
+    unsigned int total = 0;
+    for (unsigned int &offset : offsets) {
+      unsigned int count = offset;
+      offset = total;
+      total += count;
+    }
+
+    for (const Entry &entry : this->entries) this->scratch[offsets[(entry.key >> shift) & 0xff]++] = entry;
+    this->entries.swap(this->scratch);
+  }
+}
+
+void RenderQueue::flush() {
+  if (!this->entries.empty()) this->sort();
+
+  for (const Entry &entry : this->entries) {
+    if (entry.draw) {
+      // Anything drawn outside of the batch has to go on top of the sprites queued before it
+      this->batch->flush();
+      this->draws[entry.item]();
+    } else {
+      const Sprite &sprite = this->sprites[entry.item];
+      this->batch->render(sprite.texture, sprite.transform, sprite.colour, sprite.focus);
+    }
+  }
+  this->batch->flush();
+
+  this->sprites.clear();
+  this->draws.clear();
+  this->entries.clear();
+}
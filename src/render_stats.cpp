@@ -0,0 +1,53 @@
+#include "render_stats.h"
+
+unsigned int RenderStats::draw_calls = 0;
+unsigned int RenderStats::sprites = 0;
+unsigned int RenderStats::visible = 0;
+unsigned int RenderStats::culled = 0;
+unsigned long RenderStats::fill = 0;
+unsigned int RenderStats::uniforms_set = 0;
+unsigned int RenderStats::uniform_uploads = 0;
+unsigned int RenderStats::state_calls = 0;
+unsigned int RenderStats::state_elided = 0;
+unsigned long RenderStats::uploaded = 0;
+double RenderStats::upload_time = 0.0;
+double RenderStats::submit_time = 0.0;
+
+void RenderStats::reset() {
+  RenderStats::draw_calls = 0;
+  RenderStats::sprites = 0;
+  RenderStats::visible = 0;
+  RenderStats::culled = 0;
+  RenderStats::fill = 0;
+  RenderStats::uniforms_set = 0;
+  RenderStats::uniform_uploads = 0;
+  RenderStats::state_calls = 0;
+  RenderStats::state_elided = 0;
+  RenderStats::uploaded = 0;
+  RenderStats::upload_time = 0.0;
+  RenderStats::submit_time = 0.0;
+}
+
+void RenderStats::Totals::add() {
+  this->frames++;
+  this->draw_calls += RenderStats::draw_calls;
+  this->sprites += RenderStats::sprites;
+  this->visible += RenderStats::visible;
+  this->culled += RenderStats::culled;
+  this->fill += RenderStats::fill;
+  this->uniforms_set += RenderStats::uniforms_set;
+  this->uniform_uploads += RenderStats::uniform_uploads;
+  this->state_calls += RenderStats::state_calls;
+  this->state_elided += RenderStats::state_elided;
+  this->uploaded += RenderStats::uploaded;
+  this->upload_time += RenderStats::upload_time;
+  this->submit_time += RenderStats::submit_time;
+}
+
+void RenderStats::Totals::report(const char *prefix, const char *name) const {
+  if (this->frames == 0) return;
+
+  printf("%s %-20s %6lu draw calls, %6lu sprites, %6lu/%6lu visible, %7.3f Mpx filled, %5lu/%5lu uniform uploads, %5lu/%5lu state calls elided, %8.1f kB uploaded in %6.3f ms, %8.3f ms submit per frame\n", prefix, name,
+    this->draw_calls / this->frames, this->sprites / this->frames, this->visible / this->frames, (this->visible + this->culled) / this->frames, this->fill / 1e6 / this->frames, this->uniform_uploads / this->frames, this->uniforms_set / this->frames,
+    this->state_elided / this->frames, (this->state_calls + this->state_elided) / this->frames, this->uploaded / 1024.0 / this->frames, this->upload_time * 1000.0 / this->frames, this->submit_time * 1000.0 / this->frames);
+}
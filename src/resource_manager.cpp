@@ -6,9 +6,75 @@
 std::map<std::string, ::Shader> Shaders;
 std::map<std::string, ::Texture> Textures;
 
+// The GL textures shared by several textures, which are the atlases and the arrays of animation frames
+std::vector<unsigned int> SharedTextures;
+
+bool ResourceManager::Atlas::enabled = true;
+
 // std::map<char, Character> ResourceManager::Font::Characters;
 
-void ResourceManager::Font::load(const char *path, std::string font_name, unsigned int num_chars, short filtering) {
+// Turn a glyph's coverage bitmap into a signed distance field, grown by the spread on every side. Each pixel holds the
+// distance to the closest pixel on the other side of the glyph's edge, mapped so that 0.5 lies on the edge, 1.0 lies
+// the spread (or more) inside of the glyph, and 0.0 the spread (or more) outside of it. The distances are found with
+// the two passes of an 8-point sequential Euclidean distance transform.
+static std::vector<unsigned char> distance_field(const std::vector<unsigned char> &bitmap, int width, int height, int spread) {
+  int field_width = width + spread * 2, field_height = height + spread * 2;
+
+  // The offset from each pixel to the closest pixel of the other kind found so far
+  const int far = 1 << 14;
+  std::vector<glm::ivec2> outside(field_width * field_height), inside(field_width * field_height);
+  for (int y = 0; y < field_height; y++) {
+    for (int x = 0; x < field_width; x++) {
+      int gx = x - spread, gy = y - spread;
+      bool filled = gx >= 0 && gy >= 0 && gx < width && gy < height && bitmap[gy * width + gx] >= 128;
+      outside[y * field_width + x] = filled ? glm::ivec2(far) : glm::ivec2(0);
+      inside[y * field_width + x] = filled ? glm::ivec2(0) : glm::ivec2(far);
+    }
+  }
+
+  auto sweep = [&](std::vector<glm::ivec2> &grid) {
+    auto compare = [&](glm::ivec2 &point, int x, int y, int dx, int dy) {
+      if (x + dx < 0 || y + dy < 0 || x + dx >= field_width || y + dy >= field_height) return;
+      glm::ivec2 other = grid[(y + dy) * field_width + x + dx] + glm::ivec2(dx, dy);
+      if (other.x * other.x + other.y * other.y < point.x * point.x + point.y * point.y) point = other;
+    };
+
+    for (int y = 0; y < field_height; y++) {
+      for (int x = 0; x < field_width; x++) {
+        glm::ivec2 &point = grid[y * field_width + x];
+        compare(point, x, y, -1, 0);
+        compare(point, x, y, 0, -1);
+        compare(point, x, y, -1, -1);
+        compare(point, x, y, 1, -1);
+      }
+      for (int x = field_width - 1; x >= 0; x--) compare(grid[y * field_width + x], x, y, 1, 0);
+    }
+
+    for (int y = field_height - 1; y >= 0; y--) {
+      for (int x = field_width - 1; x >= 0; x--) {
+        glm::ivec2 &point = grid[y * field_width + x];
+        compare(point, x, y, 1, 0);
+        compare(point, x, y, 0, 1);
+        compare(point, x, y, -1, 1);
+        compare(point, x, y, 1, 1);
+      }
+      for (int x = 0; x < field_width; x++) compare(grid[y * field_width + x], x, y, -1, 0);
+    }
+  };
+  sweep(outside);
+  sweep(inside);
+
+  std::vector<unsigned char> field(field_width * field_height);
+  for (int i = 0; i < field_width * field_height; i++) {
+    float distance = glm::length(glm::vec2(outside[i])) - glm::length(glm::vec2(inside[i]));
+    field[i] = (unsigned char)std::round(glm::clamp(0.5f + distance / (2.0f * spread), 0.0f, 1.0f) * 255.0f);
+  }
+  return field;
+}
+
+void ResourceManager::Font::load(const char *path, std::string font_name, unsigned int num_chars) {
+  std::chrono::high_resolution_clock::time_point start_point = std::chrono::high_resolution_clock::now();
+
   // Declare the freetype library and fontface variables
   FT_Library freetype;
 
@@ -21,41 +87,102 @@ void ResourceManager::Font::load(const char *path, std::string font_name, unsign
   }
 
   // Set global glyph sizes
-  FT_Set_Pixel_Sizes(face, 0, 48);
+  FT_Set_Pixel_Sizes(face, 0, Fonts::SDF_SIZE);
 
   // Disable byte-alignment restriction
   // NOTE: Without this, the code can SEG_FAULT
   glPixelStorei(GL_UNPACK_ALIGNMENT, 1);   
 
-  // Load each character glyph from the font until the num_chars limit is reached 
+  // Render each character glyph from the font until the num_chars limit is reached, keeping their distance fields
+  // around to be packed. The field of a glyph is larger than the glyph itself, by the spread on every side.
+  typedef struct Glyph {
+    unsigned char ch;
+    std::vector<unsigned char> bitmap;
+    Character character;
+    int width, height;
+    int x, y;
+  } Glyph;
+
+  std::vector<Glyph> glyphs;
   for (unsigned char ch = 0; ch < num_chars; ch++) {
     if (FT_Load_Char(face, ch, FT_LOAD_RENDER)) {
       printf("[ERROR] ResourceManager failed to load glyph '%c' from font '%s'\n", ch, font_name.c_str()); 
       continue;
     }
 
-    // Generate the texture
-    unsigned int texture;
-    glGenTextures(1, &texture);
-    glBindTexture(GL_TEXTURE_2D, texture);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, face->glyph->bitmap.width, face->glyph->bitmap.rows, 0, GL_RED, GL_UNSIGNED_BYTE, face->glyph->bitmap.buffer);
-
-    // Set the texture options
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, (filtering == FILTER_NEAREST) ? GL_NEAREST : GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, (filtering == FILTER_NEAREST) ? GL_NEAREST : GL_LINEAR);
-
-    // Now store character for later use
-    Character character = {
-      texture, 
-      glm::ivec2(face->glyph->bitmap.width, face->glyph->bitmap.rows),
+    FT_Bitmap &bitmap = face->glyph->bitmap;
+    Glyph glyph;
+    glyph.ch = ch;
+    glyph.character = {
+      0,
+      glm::vec4(0.0f),
+      glm::ivec2(bitmap.width, bitmap.rows),
       glm::ivec2(face->glyph->bitmap_left, face->glyph->bitmap_top),
       static_cast<unsigned int>(face->glyph->advance.x)
     };
 
-    CharacterLookup[font_name].insert(std::pair<char, Character>(ch, character));
+    // FreeType rows may be padded, so copy them one by one into a tightly packed bitmap
+    glyph.bitmap.resize(bitmap.width * bitmap.rows);
+    for (unsigned int row = 0; row < bitmap.rows; row++)
+      std::memcpy(&glyph.bitmap[row * bitmap.width], bitmap.buffer + row * bitmap.pitch, bitmap.width);
+
+    // Glyphs without any pixels (like spaces) are never drawn, so they need no room in the atlas
+    glyph.width = glyph.height = 0;
+    if (bitmap.width > 0 && bitmap.rows > 0) {
+      glyph.bitmap = distance_field(glyph.bitmap, bitmap.width, bitmap.rows, Fonts::SDF_SPREAD);
+      glyph.width = bitmap.width + Fonts::SDF_SPREAD * 2;
+      glyph.height = bitmap.rows + Fonts::SDF_SPREAD * 2;
+    }
+
+    glyphs.push_back(glyph);
+  }
+
+  // Pack the glyphs into shelves, tallest first, leaving a gap between them so filtering never bleeds across glyphs
+  const int padding = 1;
+  const int atlas_width = 512;
+  std::vector<Glyph *> order;
+  for (Glyph &glyph : glyphs) order.push_back(&glyph);
+  std::stable_sort(order.begin(), order.end(), [](Glyph *a, Glyph *b) { return a->height > b->height; });
+
+  int x = padding, y = padding, shelf = 0;
+  for (Glyph *glyph : order) {
+    if (x + glyph->width + padding > atlas_width) {
+      x = padding;
+      y += shelf + padding;
+      shelf = 0;
+    }
+    glyph->x = x;
+    glyph->y = y;
+    x += glyph->width + padding;
+    shelf = std::max(shelf, glyph->height);
   }
+  int atlas_height = y + shelf + padding;
+
+  std::vector<unsigned char> pixels(atlas_width * atlas_height, 0);
+  for (Glyph &glyph : glyphs)
+    for (int row = 0; row < glyph.height; row++)
+      std::memcpy(&pixels[(glyph.y + row) * atlas_width + glyph.x], &glyph.bitmap[row * glyph.width], glyph.width);
+
+  // Upload the atlas
+  unsigned int texture;
+  glGenTextures(1, &texture);
+  GLState::edit_texture(GL_TEXTURE_2D, texture);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, atlas_width, atlas_height, 0, GL_RED, GL_UNSIGNED_BYTE, pixels.data());
+
+  // Set the texture options. Distances are always filtered linearly, as interpolating them is what keeps the edges sharp.
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+  // Now store the characters for later use
+  for (Glyph &glyph : glyphs) {
+    glyph.character.texture_id = texture;
+    glyph.character.uv = glm::vec4((float)glyph.x / atlas_width, (float)glyph.y / atlas_height, (float)glyph.width / atlas_width, (float)glyph.height / atlas_height);
+    CharacterLookup[font_name].insert(std::pair<char, Character>(glyph.ch, glyph.character));
+  }
+  double time = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start_point).count();
+  printf("[ATLAS] Font %s: %lu glyphs in a %ix%i distance field atlas, loaded in %.2f ms\n", font_name.c_str(), glyphs.size(), atlas_width, atlas_height, time * 1000.0);
 
   FT_Done_Face(face);
   FT_Done_FreeType(freetype);
@@ -141,6 +268,7 @@ void ResourceManager::Font::load(const char *path, std::string font_name, unsign
 }
 
 void ResourceManager::Shader::deallocate(std::string handle) {
+  GLState::forget_program(Shaders[handle].id);
   glDeleteProgram(Shaders[handle].id);
 }
 
@@ -168,6 +296,47 @@ void ResourceManager::Shader::deallocate(std::string handle) {
   return texture;
 }
 
+std::vector<::Texture> ResourceManager::Texture::load_frames(std::vector<std::string> file_paths, bool alpha, std::string handle) {
+  std::vector<::Texture> frames;
+  std::vector<unsigned char> pixels;
+  int frame_width = 0, frame_height = 0;
+
+  for (std::string &path : file_paths) {
+    int width, height, colour_channels;
+    unsigned char *data = ResourceManager::Image::load(path.c_str(), width, height, colour_channels);
+
+    if (pixels.empty()) {
+      frame_width = width;
+      frame_height = height;
+    } else if (width != frame_width || height != frame_height) {
+      printf("[WARNING] Frame '%s' of '%s' is %ix%i instead of %ix%i, so the frames are loaded as separate textures\n", path.c_str(), handle.c_str(), width, height, frame_width, frame_height);
+      ResourceManager::Image::deallocate(data);
+
+      for (unsigned int i = 0; i < file_paths.size(); i++)
+        frames.push_back(ResourceManager::Texture::load(file_paths[i].c_str(), alpha, handle + "-" + std::to_string(i)));
+      return frames;
+    }
+
+    // Images are always loaded with four channels, so the layers can simply be laid out one after another
+    pixels.insert(pixels.end(), data, data + (size_t)width * height * 4);
+    ResourceManager::Image::deallocate(data);
+  }
+
+  ::Texture array;
+  if (alpha) array.texture_format = GL_RGBA;
+  array.image_format = GL_RGBA;
+  array.generate(frame_width, frame_height, file_paths.size(), pixels.data());
+  SharedTextures.push_back(array.id);
+
+  for (unsigned int i = 0; i < file_paths.size(); i++) {
+    ::Texture frame = array;
+    frame.layer = i;
+    Textures[handle + "-" + std::to_string(i)] = frame;
+    frames.push_back(frame);
+  }
+  return frames;
+}
+
 ::Texture ResourceManager::Texture::get(std::string handle) {
   if (Textures.find(handle) != Textures.end())
     return Textures[handle];
@@ -175,6 +344,9 @@ void ResourceManager::Shader::deallocate(std::string handle) {
 }
 
 void ResourceManager::Texture::deallocate(std::string handle) {
+  // A packed texture or a frame only owns part of its GL texture, which has to stay around for the other textures in it
+  if (std::find(SharedTextures.begin(), SharedTextures.end(), Textures[handle].id) != SharedTextures.end()) return;
+  GLState::forget_texture(Textures[handle].id);
   glDeleteTextures(1, &Textures[handle].id);
 }
 
@@ -215,6 +387,10 @@ void ResourceManager::Texture::load_from_file(const char *file_path) {
   int objects_loaded = 0;
   int line_num = 0;
 
+  // The images to be packed into atlases once the whole file has been read
+  std::vector<ResourceManager::Atlas::Image> images;
+  std::chrono::high_resolution_clock::time_point start_point = std::chrono::high_resolution_clock::now();
+
   #define DEBUG false
   #define DEBUG_LEVEL 5
 
@@ -237,6 +413,7 @@ void ResourceManager::Texture::load_from_file(const char *file_path) {
         std::string handle = line.substr(0, pos);
         std::string path; 
         std::string transparent = "true";
+        std::string packed = "true";
 
         line.erase(0, pos + 1);
         pos = line.find(";");
@@ -244,16 +421,200 @@ void ResourceManager::Texture::load_from_file(const char *file_path) {
 
         if (pos != std::string::npos) transparent = line.substr(pos + 1);
 
+        pos = transparent.find(";");
+        if (pos != std::string::npos) {
+          packed = transparent.substr(pos + 1);
+          transparent = transparent.substr(0, pos);
+        }
+
         bool transparency;
         if (transparent == "false") transparency = false;
         else if (transparent == "true") transparency = true;
         else if (!transparent.size()) t_error("Invalid syntax at line " + std::to_string(line_num) + " (line endings should not have a semicolon)", false);
         else t_error("Invalid syntax at line " + std::to_string(line_num) + " ('" + transparent + "' invalid value)");
 
-        ResourceManager::Texture::load(path.c_str(), transparency, handle);
+        bool packing = true;
+        if (packed == "false") packing = false;
+        else if (packed != "true") t_error("Invalid syntax at line " + std::to_string(line_num) + " ('" + packed + "' invalid value)");
+
+        objects_loaded++;
+        if (!ResourceManager::Atlas::enabled || !packing) {
+          ResourceManager::Texture::load(path.c_str(), transparency, handle);
+          continue;
+        }
+
+        ResourceManager::Atlas::Image image;
+        int colour_channels;
+        image.handle = handle;
+        image.alpha = transparency;
+        image.data = ResourceManager::Image::load(path.c_str(), image.width, image.height, colour_channels);
+        images.push_back(image);
+      }
+    }
+  }
+
+  ResourceManager::Atlas::pack(images);
+  for (ResourceManager::Atlas::Image &image : images) ResourceManager::Image::deallocate(image.data);
+
+  double time = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start_point).count();
+  printf("[ATLAS] Loaded %i textures from %s in %.2f ms (%lu packed)\n", objects_loaded, file_path, time * 1000.0, images.size());
+}
+
+// The skyline of an atlas is the top edge of everything packed into it so far, stored as segments from left to right.
+// As rows grow downwards in an image, the skyline is really the bottom edge, and images are stacked below it.
+typedef struct SkylineSegment {
+  int x, y, width;
+} SkylineSegment;
+
+// Find where a rectangle would sit if placed at the start of the given segment, resting on the highest segment it spans
+static bool skyline_fit(const std::vector<SkylineSegment> &skyline, unsigned int index, int width, int height, int &y) {
+  int x = skyline[index].x;
+  if (x + width > ResourceManager::Atlas::MAX_SIZE) return false;
+
+  y = 0;
+  int remaining = width;
+  for (unsigned int i = index; remaining > 0; i++) {
+    if (i >= skyline.size()) return false;
+    y = std::max(y, skyline[i].y);
+    if (y + height > ResourceManager::Atlas::MAX_SIZE) return false;
+    remaining -= skyline[i].width;
+  }
+  return true;
+}
+
+// Raise the skyline over a rectangle placed at the start of the given segment
+static void skyline_place(std::vector<SkylineSegment> &skyline, unsigned int index, int width, int height, int y) {
+  SkylineSegment placed = { skyline[index].x, y + height, width };
+  skyline.insert(skyline.begin() + index, placed);
+
+  // Cut away the parts of the segments the rectangle now covers
+  for (unsigned int i = index + 1; i < skyline.size();) {
+    int overlap = placed.x + placed.width - skyline[i].x;
+    if (overlap <= 0) break;
+
+    if (overlap >= skyline[i].width) {
+      skyline.erase(skyline.begin() + i);
+      continue;
+    }
+    skyline[i].x += overlap;
+    skyline[i].width -= overlap;
+    break;
+  }
+
+  // Merge neighbouring segments at the same height
+  for (unsigned int i = 0; i + 1 < skyline.size();) {
+    if (skyline[i].y == skyline[i + 1].y) {
+      skyline[i].width += skyline[i + 1].width;
+      skyline.erase(skyline.begin() + i + 1);
+    } else i++;
+  }
+}
+
+void ResourceManager::Atlas::pack(std::vector<Image> &images) {
+  using ResourceManager::Atlas::MAX_SIZE;
+  using ResourceManager::Atlas::PADDING;
+
+  // Every image is loaded with the same filtering, so the transparency is the only setting atlases are split by
+  for (int alpha = 0; alpha < 2; alpha++) {
+    // Place the tallest images first, which keeps the skyline flat
+    std::vector<Image *> queue;
+    for (Image &image : images) {
+      if (image.alpha != (bool)alpha) continue;
+
+      // Images which do not fit into an atlas are simply given a texture of their own
+      if (image.width + PADDING * 2 > MAX_SIZE || image.height + PADDING * 2 > MAX_SIZE) {
+        ::Texture texture;
+        if (image.alpha) texture.texture_format = GL_RGBA;
+        texture.image_format = GL_RGBA;
+        texture.generate(image.width, image.height, image.data);
+        Textures[image.handle] = texture;
+        continue;
       }
+      queue.push_back(&image);
     }
+    std::stable_sort(queue.begin(), queue.end(), [](Image *a, Image *b) { return a->height > b->height || (a->height == b->height && a->width > b->width); });
+
+    // Place each image on the atlas (and segment) where it ends up highest, opening a new atlas when none has room
+    std::vector<std::vector<SkylineSegment>> skylines;
+    std::vector<std::vector<std::pair<Image *, glm::ivec2>>> placements;
+    for (Image *image : queue) {
+      int width = image->width + PADDING * 2, height = image->height + PADDING * 2;
+      int best_page = -1, best_index = -1, best_y = MAX_SIZE + 1;
+
+      for (int page = 0; page < (int)skylines.size() && best_page < 0; page++) {
+        for (unsigned int i = 0; i < skylines[page].size(); i++) {
+          int y;
+          if (!skyline_fit(skylines[page], i, width, height, y) || y >= best_y) continue;
+          best_index = i;
+          best_y = y;
+        }
+        if (best_index >= 0) best_page = page;
+      }
+
+      if (best_page < 0) {
+        skylines.push_back({ { 0, 0, MAX_SIZE } });
+        placements.push_back({});
+        best_page = skylines.size() - 1;
+        best_index = 0;
+        best_y = 0;
+      }
+
+      placements[best_page].push_back({ image, glm::ivec2(skylines[best_page][best_index].x + PADDING, best_y + PADDING) });
+      skyline_place(skylines[best_page], best_index, width, height, best_y);
+    }
+
+    // Copy the images into each atlas, cropped to the area actually used, and hand out a texture for each region
+    for (unsigned int page = 0; page < placements.size(); page++) {
+      int atlas_width = 0, atlas_height = 0;
+      long used = 0;
+      for (std::pair<Image *, glm::ivec2> &placement : placements[page]) {
+        atlas_width = std::max(atlas_width, placement.second.x + placement.first->width + PADDING);
+        atlas_height = std::max(atlas_height, placement.second.y + placement.first->height + PADDING);
+        used += (long)placement.first->width * placement.first->height;
+      }
+
+      std::vector<unsigned char> pixels((size_t)atlas_width * atlas_height * 4, 0);
+      for (std::pair<Image *, glm::ivec2> &placement : placements[page]) {
+        Image *image = placement.first;
+        for (int y = -PADDING; y < image->height + PADDING; y++) {
+          for (int x = -PADDING; x < image->width + PADDING; x++) {
+            // The padding repeats the nearest pixel on the edge of the image
+            int source_x = std::clamp(x, 0, image->width - 1), source_y = std::clamp(y, 0, image->height - 1);
+            unsigned char *source = image->data + ((size_t)source_y * image->width + source_x) * 4;
+            unsigned char *target = pixels.data() + ((size_t)(placement.second.y + y) * atlas_width + placement.second.x + x) * 4;
+            std::copy(source, source + 4, target);
+          }
+        }
+      }
+
+      ::Texture atlas;
+      if (alpha) atlas.texture_format = GL_RGBA;
+      atlas.image_format = GL_RGBA;
+      atlas.generate(atlas_width, atlas_height, pixels.data());
+      SharedTextures.push_back(atlas.id);
+
+      for (std::pair<Image *, glm::ivec2> &placement : placements[page]) {
+        ::Texture texture = atlas;
+        texture.width = placement.first->width;
+        texture.height = placement.first->height;
+        texture.uv = glm::vec4(
+          (float)placement.second.x / atlas_width, (float)placement.second.y / atlas_height,
+          (float)placement.first->width / atlas_width, (float)placement.first->height / atlas_height
+        );
+        Textures[placement.first->handle] = texture;
+      }
+
+      printf("[ATLAS] Atlas %u (%s): %ix%i, %lu textures, %.1f%% of the area used\n", page, alpha ? "RGBA" : "RGB", atlas_width, atlas_height, placements[page].size(), 100.0 * used / ((double)atlas_width * atlas_height));
+    }
+  }
+}
+
+void ResourceManager::Atlas::deallocate() {
+  for (unsigned int id : SharedTextures) {
+    GLState::forget_texture(id);
+    glDeleteTextures(1, &id);
   }
+  SharedTextures.clear();
 }
 
 unsigned char *ResourceManager::Image::load(const char *file_path) {
@@ -268,11 +629,15 @@ void ResourceManager::Image::deallocate(unsigned char *image_data) {
 void ResourceManager::deallocate() {
   // Deallocate all shaders
   for (auto shader : Shaders) {
+    GLState::forget_program(shader.second.id);
     glDeleteProgram(shader.second.id);
   }
 
-  // Deallocate all textures
+  // Deallocate all textures, skipping the shared ones so each of them is only deleted once below
   for (auto texture : Textures) {
+    if (std::find(SharedTextures.begin(), SharedTextures.end(), texture.second.id) != SharedTextures.end()) continue;
+    GLState::forget_texture(texture.second.id);
     glDeleteTextures(1, &texture.second.id);
   }
+  ResourceManager::Atlas::deallocate();
 }
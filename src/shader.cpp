@@ -26,6 +26,7 @@ void Shader::compile(const char *vertex_code, const char *fragment_code, const c
   glAttachShader(id, geometry_shader);
   glLinkProgram(id);
   compile_errors(id, "program");
+  reflect();
 
   // Delete the shaders as they have already been linked to the shader
   glDeleteShader(vertex_shader);
@@ -52,6 +53,7 @@ void Shader::compile(const char *vertex_code, const char *fragment_code) {
   glAttachShader(id, fragment_shader);
   glLinkProgram(id);
   compile_errors(id, "program");
+  reflect();
 
   // Delete the shaders as they have already been linked to the shader
   glDeleteShader(vertex_shader);
@@ -59,54 +61,168 @@ void Shader::compile(const char *vertex_code, const char *fragment_code) {
 }
 
 void Shader::activate() {
-  glUseProgram(id);
+  GLState::use_program(id);
+}
+
+const UniformId Uniforms::MODEL = Shader::uniform("model");
+const UniformId Uniforms::COLOUR = Shader::uniform("colour");
+const UniformId Uniforms::FOCUS = Shader::uniform("focus");
+const UniformId Uniforms::REGION = Shader::uniform("region");
+const UniformId Uniforms::SPRITE = Shader::uniform("sprite");
+const UniformId Uniforms::FRAMES = Shader::uniform("frames");
+const UniformId Uniforms::LAYER = Shader::uniform("layer");
+const UniformId Uniforms::TEXT_COLOUR = Shader::uniform("text_colour");
+
+// The ids handed out so far, by the names of their uniforms
+static std::map<std::string, UniformId> &uniform_ids() {
+  static std::map<std::string, UniformId> ids;
+  return ids;
+}
+
+UniformId Shader::uniform(const char *name) {
+  std::map<std::string, UniformId> &ids = uniform_ids();
+  std::map<std::string, UniformId>::iterator it = ids.find(name);
+  if (it != ids.end()) return it->second;
+
+  UniformId id = ids.size();
+  ids[name] = id;
+  return id;
+}
+
+void Shader::reflect() {
+  this->uniforms = std::make_shared<std::vector<UniformSlot>>();
+
+  unsigned int camera = glGetUniformBlockIndex(this->id, "Camera");
+  if (camera != GL_INVALID_INDEX) glUniformBlockBinding(this->id, camera, UniformBlocks::CAMERA);
+
+  GLint count = 0;
+  glGetProgramiv(this->id, GL_ACTIVE_UNIFORMS, &count);
+  for (GLint i = 0; i < count; i++) {
+    char name[256];
+    GLint size;
+    GLenum type;
+    glGetActiveUniform(this->id, i, sizeof(name), NULL, &size, &type, name);
+
+    // Arrays are reported by the name of their first element, but are set by the name of the array
+    char *bracket = std::strchr(name, '[');
+    if (bracket != NULL) *bracket = '\0';
+
+    // Uniforms inside of blocks have no location, as they are read from a buffer
+    GLint block;
+    glGetActiveUniformsiv(this->id, 1, (GLuint *)&i, GL_UNIFORM_BLOCK_INDEX, &block);
+    if (block != -1) continue;
+
+    UniformId uniform = Shader::uniform(name);
+    if (uniform >= this->uniforms->size()) this->uniforms->resize(uniform + 1);
+    (*this->uniforms)[uniform].location = glGetUniformLocation(this->id, name);
+  }
+}
+
+int Shader::upload_location(UniformId uniform, const void *value, std::size_t size) {
+  RenderStats::uniforms_set++;
+  if (!this->uniforms) return -1;
+
+  // Every active uniform got an id when the program was linked, so anything past the table is not in the program
+  if (uniform >= this->uniforms->size()) this->uniforms->resize(uniform + 1);
+  UniformSlot &slot = (*this->uniforms)[uniform];
+
+  if (slot.location < 0) {
+    if (!slot.warned) {
+      for (const std::pair<const std::string, UniformId> &pair : uniform_ids()) {
+        if (pair.second == uniform) printf("[WARNING] Shader %i has no uniform '%s'\n", this->id, pair.first.c_str());
+      }
+      slot.warned = true;
+    }
+    return -1;
+  }
+
+  if (slot.cached && std::memcmp(slot.value, value, size) == 0) return -1;
+  std::memcpy(slot.value, value, size);
+  slot.cached = true;
+
+  RenderStats::uniform_uploads++;
+  return slot.location;
+}
+
+void Shader::set_bool(UniformId uniform, bool value) {
+  this->set_integer(uniform, value ? 1 : 0);
+}
+
+void Shader::set_float(UniformId uniform, float value) {
+  int location = this->upload_location(uniform, &value, sizeof(value));
+  if (location >= 0) glUniform1f(location, value);
+}
+
+void Shader::set_integer(UniformId uniform, int value) {
+  int location = this->upload_location(uniform, &value, sizeof(value));
+  if (location >= 0) glUniform1i(location, value);
+}
+
+void Shader::set_vector_2f(UniformId uniform, const glm::vec2 &value) {
+  int location = this->upload_location(uniform, &value, sizeof(value));
+  if (location >= 0) glUniform2f(location, value.x, value.y);
+}
+
+void Shader::set_vector_3f(UniformId uniform, const glm::vec3 &value) {
+  int location = this->upload_location(uniform, &value, sizeof(value));
+  if (location >= 0) glUniform3f(location, value.x, value.y, value.z);
+}
+
+void Shader::set_vector_4f(UniformId uniform, const glm::vec4 &value) {
+  int location = this->upload_location(uniform, &value, sizeof(value));
+  if (location >= 0) glUniform4f(location, value.x, value.y, value.z, value.w);
+}
+
+void Shader::set_matrix_4f(UniformId uniform, const glm::mat4 &value) {
+  int location = this->upload_location(uniform, &value, sizeof(value));
+  if (location >= 0) glUniformMatrix4fv(location, 1, false, glm::value_ptr(value));
 }
 
 void Shader::set_float(const char *handle, float value) {
-  glUniform1f(glGetUniformLocation(this->id, handle), value);
+  this->set_float(Shader::uniform(handle), value);
 }
 
 void Shader::set_integer(const char *handle, int value) {
-  glUniform1i(glGetUniformLocation(this->id, handle), value);
+  this->set_integer(Shader::uniform(handle), value);
 }
 
 void Shader::set_vector_2f(const char *handle, float x, float y) {
-  glUniform2f(glGetUniformLocation(this->id, handle), x, y);
+  this->set_vector_2f(Shader::uniform(handle), glm::vec2(x, y));
 }
 
 void Shader::set_vector_2f(const char *handle, const glm::vec2 &value) {
-  glUniform2f(glGetUniformLocation(this->id, handle), value.x, value.y);
+  this->set_vector_2f(Shader::uniform(handle), value);
 }
 
 void Shader::set_vector_3f(const char *handle, float x, float y, float z) {
-  glUniform3f(glGetUniformLocation(this->id, handle), x, y, z);
+  this->set_vector_3f(Shader::uniform(handle), glm::vec3(x, y, z));
 }
 
 void Shader::set_vector_3f(const char *handle, const glm::vec3 &value) {
-  glUniform3f(glGetUniformLocation(this->id, handle), value.x, value.y, value.z);
+  this->set_vector_3f(Shader::uniform(handle), value);
 }
 
 void Shader::set_vector_4f(const char *handle, float x, float y, float z, float w) {
-  glUniform4f(glGetUniformLocation(this->id, handle), x, y, z, w);
+  this->set_vector_4f(Shader::uniform(handle), glm::vec4(x, y, z, w));
 }
 
 void Shader::set_vector_4f(const char *handle, const glm::vec4 &value) {
-  glUniform4f(glGetUniformLocation(this->id, handle), value.x, value.y, value.z, value.w);
+  this->set_vector_4f(Shader::uniform(handle), value);
 }
 
 void Shader::set_matrix_4f(const char *handle, const glm::mat4 &value) {
-  glUniformMatrix4fv(glGetUniformLocation(this->id, handle), 1, false, glm::value_ptr(value));
+  this->set_matrix_4f(Shader::uniform(handle), value);
 }
 
 void Shader::set_bool(const char *handle, bool value) {
-  glUniform1i(glGetUniformLocation(this->id, handle), value ? 1 : 0);
+  this->set_bool(Shader::uniform(handle), value);
 }
 
 // Check if the shaders compile
 void Shader::compile_errors(unsigned int shader, const char *type) {
   GLint has_compiled;
   char info_log[1024];
-  if (type != "program") {
+  if (std::strcmp(type, "program") != 0) {
     glGetShaderiv(shader, GL_COMPILE_STATUS, &has_compiled);
     if (has_compiled == GL_FALSE) {
       glGetShaderInfoLog(shader, 1024, NULL, info_log);
@@ -114,10 +230,10 @@ void Shader::compile_errors(unsigned int shader, const char *type) {
       printf("%s\n", info_log);
     }
   } else {
-    glGetProgramiv(shader, GL_COMPILE_STATUS, &has_compiled);
+    glGetProgramiv(shader, GL_LINK_STATUS, &has_compiled);
     if (has_compiled == GL_FALSE) {
       glGetProgramInfoLog(shader, 1024, NULL, info_log);
-      printf("[ERROR] Shader %i could not compile the %s shader.\n", this->id, type);
+      printf("[ERROR] Shader %i could not link the %s.\n", this->id, type);
       printf("%s\n", info_log);
     }
   }
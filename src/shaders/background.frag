@@ -0,0 +1,34 @@
+#version 330 core
+
+// Output the fragment colour, with its alpha already multiplied in
+out vec4 pixel;
+
+in vec2 world_position;
+
+// The layers from back to front. The columns of the matrices hold the rectangle each layer covers in world space,
+// as (x, y, width, height), and the region of its texture it samples (see Texture::uv).
+uniform sampler2D layer0;
+uniform sampler2D layer1;
+uniform sampler2D layer2;
+uniform sampler2D layer3;
+uniform mat4 rects;
+uniform mat4 regions;
+uniform int layer_count;
+
+// Blend a layer over what is below it, if the layer covers the pixel
+vec4 over(vec4 below, sampler2D layer, vec4 rect, vec4 region) {
+  vec2 local = (world_position - rect.xy) / rect.zw;
+  if (any(lessThan(local, vec2(0.0))) || any(greaterThanEqual(local, vec2(1.0)))) return below;
+
+  vec4 colour = textureLod(layer, region.xy + local * region.zw, 0.0);
+  return vec4(colour.rgb * colour.a, colour.a) + below * (1.0 - colour.a);
+}
+
+void main() {
+  // Composite every layer in registers, so each pixel of the screen is only written once
+  pixel = vec4(0.0);
+  if (layer_count > 0) pixel = over(pixel, layer0, rects[0], regions[0]);
+  if (layer_count > 1) pixel = over(pixel, layer1, rects[1], regions[1]);
+  if (layer_count > 2) pixel = over(pixel, layer2, rects[2], regions[2]);
+  if (layer_count > 3) pixel = over(pixel, layer3, rects[3], regions[3]);
+}
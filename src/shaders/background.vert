@@ -0,0 +1,18 @@
+#version 330 core
+
+// The background is a single quad covering the screen, so its corners are worked out from the vertex id
+out vec2 world_position;
+
+// Stretch the unit quad over the screen
+uniform mat4 model;
+
+layout (std140) uniform Camera {
+  mat4 projection;
+  mat4 view;
+};
+
+void main() {
+  vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+  world_position = (model * vec4(corner, 0.0, 1.0)).xy;
+  gl_Position = projection * view * vec4(world_position, 0.0, 1.0);
+}
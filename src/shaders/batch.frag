@@ -0,0 +1,28 @@
+#version 330 core
+
+// Output the fragment colour we calculate in this shader
+out vec4 pixel;
+
+// Get the texture coordinates, the colour and the focus that were output from the vertex shader
+in vec2 texture_coordinate;
+in vec2 local_coordinate;
+in vec4 colour;
+flat in int focus;
+flat in int layer;
+
+// The textures shared by the whole batch. Sprites with a layer are frames of an animation, stored in an array texture.
+uniform sampler2D sprite;
+uniform sampler2DArray frames;
+
+void main() {
+  // Set the default pixel colour
+  if (layer >= 0) pixel = colour * texture(frames, vec3(texture_coordinate, layer));
+  else pixel = colour * texture(sprite, texture_coordinate);
+
+  // Highlight the border of focused sprites, the same way the default shader does
+  if (local_coordinate.x <= 0.005f || local_coordinate.x >= 0.995f || local_coordinate.y <= 0.005f || local_coordinate.y >= 0.995f) {
+    if (focus == 1) { pixel += vec4(0.796f, 0.482f, 0.494f, 0.6f); }
+    else if (focus == -1) { pixel += vec4(0.4f, 0.4f, 0.4f, 0.6f); }
+    else if (focus == -2) { pixel += vec4(1.0f, 0.843f, 0.0f, 0.6f); }
+  }
+}
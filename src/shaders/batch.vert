@@ -0,0 +1,33 @@
+#version 330 core
+
+// Every vertex carries everything the sprite it belongs to needs, as a whole batch is drawn at once
+layout (location = 0) in vec2 vertex;
+layout (location = 1) in vec2 texture;
+layout (location = 2) in vec4 tint;
+layout (location = 3) in float highlight;
+layout (location = 4) in vec2 local;
+layout (location = 5) in float frame;
+
+// Output the texture coordinate, the colour and the focus of the sprite for each pixel
+out vec2 texture_coordinate;
+out vec2 local_coordinate;
+out vec4 colour;
+flat out int focus;
+flat out int layer;
+
+layout (std140) uniform Camera {
+  mat4 projection;
+  mat4 view;
+};
+
+void main() {
+  // Calculate the OpenGL vertex position
+  gl_Position = projection * view * vec4(vertex, 0.0, 1.0);
+
+  // Pass the sprite's settings on to the fragment shader
+  texture_coordinate = texture;
+  local_coordinate = local;
+  colour = tint;
+  focus = int(round(highlight));
+  layer = int(round(frame));
+}
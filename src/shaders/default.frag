@@ -5,18 +5,22 @@ out vec4 pixel;
 
 // Get the colours and the texture coordinates that were output from the vertex shader
 in vec2 texture_coordinate;
+in vec2 local_coordinate;
 
-// The texture and the colour uniform
+// The texture and the colour uniform. Frames of animations come from an array texture instead, from the given layer.
 uniform sampler2D sprite;
+uniform sampler2DArray frames;
+uniform int layer;
 uniform vec4 colour;
 uniform int focus;
 
 void main() {
   // Set the default pixel colour
-  pixel = colour * texture(sprite, texture_coordinate);
+  if (layer >= 0) pixel = colour * texture(frames, vec3(texture_coordinate, layer));
+  else pixel = colour * texture(sprite, texture_coordinate);
 
   // Display the texture
-  if (texture_coordinate.x <= 0.005f || texture_coordinate.x >= 0.995f || texture_coordinate.y <= 0.005f || texture_coordinate.y >= 0.995f) {
+  if (local_coordinate.x <= 0.005f || local_coordinate.x >= 0.995f || local_coordinate.y <= 0.005f || local_coordinate.y >= 0.995f) {
     if (focus == 1) { pixel += vec4(0.796f, 0.482f, 0.494f, 0.6f); }
     else if (focus == -1) { pixel += vec4(0.4f, 0.4f, 0.4f, 0.6f); }
     else if (focus == -2) { pixel += vec4(1.0f, 0.843f, 0.0f, 0.6f); }
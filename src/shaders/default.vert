@@ -4,19 +4,30 @@
 layout (location = 0) in vec2 vertex;
 layout (location = 1) in vec2 texture;
 
-// Output the color and texture coordinate for each pixel
+// Output the color and texture coordinate for each pixel, and where the pixel lies within the sprite
 out vec2 texture_coordinate;
+out vec2 local_coordinate;
 
-// Uniform matrices for conversion from local space to world space to screen space
+// Uniform matrix for conversion from local space to world space
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+
+// The camera's matrices for conversion from world space to screen space, read from a uniform block every shader
+// shares (see Camera::bind)
+layout (std140) uniform Camera {
+  mat4 projection;
+  mat4 view;
+};
+
 uniform bool highlight;
 
+// The region of the texture the sprite covers, which is only part of it for textures packed into an atlas
+uniform vec4 region;
+
 void main() {
   // Calculate the OpenGL vertex position
   gl_Position = projection * view * model * vec4(vertex, 0.0, 1.0);
 
   // Output the correct texture coordinate for each vertex
-  texture_coordinate = texture;
+  texture_coordinate = region.xy + texture * region.zw;
+  local_coordinate = texture;
 }
@@ -3,10 +3,15 @@
 in vec2 texture_coordinates;
 out vec4 colour;
 
+// The atlas holds the signed distance field of each glyph, where 0.5 lies right on the edge of the glyph
 uniform sampler2D text;
 uniform vec4 text_colour;
 
 void main() {
-  vec4 sampled = vec4(1.0f, 1.0f, 1.0f, texture(text, texture_coordinates).r);
-  colour = text_colour * sampled;
+  // Blend across about a pixel on the screen, however large the text is drawn
+  float distance = texture(text, texture_coordinates).r;
+  float smoothing = 0.5 * fwidth(distance);
+  float alpha = smoothstep(0.5 - smoothing, 0.5 + smoothing, distance);
+
+  colour = text_colour * vec4(1.0, 1.0, 1.0, alpha);
 }
@@ -3,11 +3,15 @@
 layout (location = 0) in vec4 vertex; // <vec2 pos, vec2 tex>
 out vec2 texture_coordinates;
 
-uniform mat4 projection;
-// uniform mat4 model;
+layout (std140) uniform Camera {
+  mat4 projection;
+  mat4 view;
+};
+
+// Move a laid out string into place on the screen
+uniform mat4 model;
 
 void main() {
-  // gl_Position = projection * model * vec4(vertex.xy, 0.0, 1.0);
-  gl_Position = projection * vec4(vertex.xy, 0.0, 1.0);
+  gl_Position = projection * model * vec4(vertex.xy, 0.0, 1.0);
   texture_coordinates = vertex.zw;
 }
@@ -30,14 +30,14 @@ SpriteRenderer::SpriteRenderer(Shader &shader, OrthoCamera *camera) {
   glGenBuffers(1, &this->ebo);
 
   // Bind the VAO to prepare for everthing else
-  glBindVertexArray(this->vao);
+  GLState::bind_vertex_array(this->vao);
 
   // Bind the VBO and set some options for it
-  glBindBuffer(GL_ARRAY_BUFFER, vbo);
+  GLState::bind_buffer(GL_ARRAY_BUFFER, vbo);
   glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_DYNAMIC_DRAW);
 
   // Bind the EBO and set some options for it
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->ebo);
+  GLState::bind_buffer(GL_ELEMENT_ARRAY_BUFFER, this->ebo);
   glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_DYNAMIC_DRAW);
 
   // Edit some options for the VAOs after modifying both the EBO and the VBO
@@ -47,25 +47,41 @@ SpriteRenderer::SpriteRenderer(Shader &shader, OrthoCamera *camera) {
   glEnableVertexAttribArray(1);
 
   // Free up memory by unbinding the VAO, VBO, and the EBO
-  glBindVertexArray(0);
-  glBindBuffer(GL_ARRAY_BUFFER, 0);
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+  GLState::bind_vertex_array(0);
+  GLState::bind_buffer(GL_ARRAY_BUFFER, 0);
+  GLState::bind_buffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
   // Delete the VBO buffer as it is no longer needed
+  GLState::forget_buffer(vbo);
   glDeleteBuffers(1, &vbo);
 
-  // Apply the projection and the view matrix to the camera
+  // The camera's matrices are read from its uniform buffer, so only the samplers are set here.
+  // Regular textures are sampled from the first texture unit, and the frames of animations from the second.
   shader.activate();
-  shader.set_matrix_4f("projection", camera->projection_matrix);
-  shader.set_matrix_4f("view", camera->view_matrix);
+  shader.set_integer(Uniforms::SPRITE, 0);
+  shader.set_integer(Uniforms::FRAMES, 1);
+  shader.set_integer(Uniforms::LAYER, -1);
 }
 
 SpriteRenderer::~SpriteRenderer() {
   // This runs whenever the sprite renderer is destroyed, so it destroys itself automatically.
+  GLState::forget_vertex_array(this->vao);
+  GLState::forget_buffer(this->ebo);
   glDeleteVertexArrays(1, &this->vao);
   glDeleteBuffers(1, &this->ebo);
 }
 
+// The number of pixels a sprite covers on the screen of the camera. Rotated sprites are counted as if they were not
+// rotated, which is close enough for the statistics this is used for.
+static unsigned long sprite_fill(Transform transform, const OrthoCamera *camera) {
+  float left = std::fmax(transform.position.x + std::fmin(transform.scale.x, 0.0f), 0.0f);
+  float right = std::fmin(transform.position.x + std::fmax(transform.scale.x, 0.0f), (float)camera->width);
+  float top = std::fmax(transform.position.y + std::fmin(transform.scale.y, 0.0f), 0.0f);
+  float bottom = std::fmin(transform.position.y + std::fmax(transform.scale.y, 0.0f), (float)camera->height);
+  if (right <= left || bottom <= top) return 0;
+  return (unsigned long)((right - left) * (bottom - top));
+}
+
 void SpriteRenderer::render(Texture texture, Transform transform, glm::vec4 colour, int focus) {
   // Active this shader before starting the rendering process
   this->shader.activate();
@@ -89,16 +105,237 @@ void SpriteRenderer::render(Texture texture, Transform transform, glm::vec4 colo
   model_transform = glm::scale(model_transform, glm::vec3(transform.scale, 0.0f));
 
   // Actually apply these transformations to the sprite
-  this->shader.set_matrix_4f("model", model_transform);
+  this->shader.set_matrix_4f(Uniforms::MODEL, model_transform);
 
   // Prepare the texture
-  this->shader.set_vector_4f("colour", colour);
-  this->shader.set_integer("focus", focus);
-  glActiveTexture(GL_TEXTURE0);
-  texture.bind();
+  this->shader.set_vector_4f(Uniforms::COLOUR, colour);
+  this->shader.set_vector_4f(Uniforms::REGION, texture.uv);
+  this->shader.set_integer(Uniforms::FOCUS, focus);
+
+  // Frames of an animation are sampled from an array texture on the second unit instead
+  this->shader.set_integer(Uniforms::LAYER, (texture.target == GL_TEXTURE_2D_ARRAY) ? (int)texture.layer : -1);
+  texture.bind(texture.target == GL_TEXTURE_2D_ARRAY ? 1 : 0);
 
-  // Bind the VAO, render the sprite, then unbind the VAO
-  glBindVertexArray(this->vao);
+  // Bind the VAO and render the sprite. The VAO is left bound, as the next sprite most likely uses it too.
+  GLState::bind_vertex_array(this->vao);
   glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-  glBindVertexArray(0);
+
+  RenderStats::draw_calls++;
+  RenderStats::sprites++;
+  RenderStats::fill += sprite_fill(transform, this->camera);
+}
+
+void sprite_attributes() {
+  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(SpriteVertex), (void *)offsetof(SpriteVertex, position));
+  glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(SpriteVertex), (void *)offsetof(SpriteVertex, texture_coordinate));
+  glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(SpriteVertex), (void *)offsetof(SpriteVertex, colour));
+  glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, sizeof(SpriteVertex), (void *)offsetof(SpriteVertex, focus));
+  glVertexAttribPointer(4, 2, GL_FLOAT, GL_FALSE, sizeof(SpriteVertex), (void *)offsetof(SpriteVertex, local_coordinate));
+  glVertexAttribPointer(5, 1, GL_FLOAT, GL_FALSE, sizeof(SpriteVertex), (void *)offsetof(SpriteVertex, layer));
+  glEnableVertexAttribArray(0);
+  glEnableVertexAttribArray(1);
+  glEnableVertexAttribArray(2);
+  glEnableVertexAttribArray(3);
+  glEnableVertexAttribArray(4);
+  glEnableVertexAttribArray(5);
+}
+
+std::vector<unsigned int> sprite_indices(unsigned int count) {
+  std::vector<unsigned int> indices;
+  indices.reserve(count * 6);
+  for (unsigned int i = 0; i < count; i++) {
+    unsigned int first = i * 4;
+    indices.insert(indices.end(), { first, first + 1, first + 2, first, first + 3, first + 2 });
+  }
+  return indices;
+}
+
+void sprite_quad(Transform transform, const Texture &texture, glm::vec4 colour, int focus, SpriteVertex *quad) {
+  glm::vec4 uv = texture.uv;
+  float layer = (texture.target == GL_TEXTURE_2D_ARRAY) ? (float)texture.layer : -1.0f;
+
+  // Scale the unit quad, then rotate it about (0.5, 0.5), then translate it, like the model matrix of SpriteRenderer::render
+  glm::vec2 position = glm::vec2(transform.position);
+  glm::vec2 corners[4] = { glm::vec2(0.0f, 0.0f), glm::vec2(0.0f, 1.0f), glm::vec2(1.0f, 1.0f), glm::vec2(1.0f, 0.0f) };
+
+  if (transform.rotation == 0.0f) {
+    for (int i = 0; i < 4; i++)
+      quad[i] = { position + corners[i] * transform.scale, glm::vec2(uv) + corners[i] * glm::vec2(uv.z, uv.w), corners[i], colour, (float)focus, layer };
+    return;
+  }
+
+  float angle = glm::radians(transform.rotation);
+  float c = std::cos(angle), s = std::sin(angle);
+  for (int i = 0; i < 4; i++) {
+    glm::vec2 local = corners[i] * transform.scale - glm::vec2(0.5f);
+    quad[i] = { position + glm::vec2(0.5f) + glm::vec2(c * local.x - s * local.y, s * local.x + c * local.y), glm::vec2(uv) + corners[i] * glm::vec2(uv.z, uv.w), corners[i], colour, (float)focus, layer };
+  }
+}
+
+SpriteBatch::SpriteBatch(Shader &shader, OrthoCamera *camera, unsigned int capacity) {
+  this->shader = shader;
+  this->camera = camera;
+  this->capacity = capacity;
+  this->texture = 0;
+  this->frames = 0;
+  this->vertices.reserve(capacity * 4);
+
+  glGenVertexArrays(1, &this->vao);
+  glGenBuffers(1, &this->ebo);
+  GLState::bind_vertex_array(this->vao);
+
+  // The vertices are streamed in on every flush, so they are sourced from the shared stream buffer
+  GLState::bind_buffer(GL_ARRAY_BUFFER, StreamBuffer::id());
+
+  std::vector<unsigned int> indices = sprite_indices(capacity);
+  GLState::bind_buffer(GL_ELEMENT_ARRAY_BUFFER, this->ebo);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * indices.size(), indices.data(), GL_STATIC_DRAW);
+
+  sprite_attributes();
+
+  // Unbind the VAO before the buffers, so that the EBO stays bound to it
+  GLState::bind_vertex_array(0);
+  GLState::bind_buffer(GL_ARRAY_BUFFER, 0);
+  GLState::bind_buffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+SpriteBatch::~SpriteBatch() {
+  GLState::forget_vertex_array(this->vao);
+  GLState::forget_buffer(this->ebo);
+  glDeleteVertexArrays(1, &this->vao);
+  glDeleteBuffers(1, &this->ebo);
+}
+
+void SpriteBatch::render(Texture texture, Transform transform, glm::vec4 colour, int focus) {
+  // A draw call can only sample a single regular and a single array texture, so a different one starts a new batch
+  unsigned int &bound = (texture.target == GL_TEXTURE_2D_ARRAY) ? this->frames : this->texture;
+  if ((bound != 0 && bound != texture.id) || this->vertices.size() >= this->capacity * 4) this->flush();
+  bound = texture.id;
+
+  this->vertices.resize(this->vertices.size() + 4);
+  sprite_quad(transform, texture, colour, focus, &this->vertices[this->vertices.size() - 4]);
+  RenderStats::sprites++;
+  RenderStats::fill += sprite_fill(transform, this->camera);
+}
+
+void SpriteBatch::flush() {
+  if (this->vertices.empty()) return;
+
+  this->shader.activate();
+  this->shader.set_integer(Uniforms::SPRITE, 0);
+  this->shader.set_integer(Uniforms::FRAMES, 1);
+  GLState::bind_texture(1, GL_TEXTURE_2D_ARRAY, this->frames);
+  GLState::bind_texture(0, GL_TEXTURE_2D, this->texture);
+
+  // Append the vertices to the stream buffer, after the ones already drawn, so the upload never has to wait for a
+  // previous draw call to finish reading from them
+  unsigned int count = this->vertices.size();
+  unsigned int first = StreamBuffer::write(this->vertices.data(), sizeof(SpriteVertex) * count, sizeof(SpriteVertex));
+
+  GLState::bind_vertex_array(this->vao);
+  glDrawElementsBaseVertex(GL_TRIANGLES, (count / 4) * 6, GL_UNSIGNED_INT, 0, first);
+
+  RenderStats::draw_calls++;
+  this->vertices.clear();
+  this->texture = this->frames = 0;
+}
+
+SpriteLayer::SpriteLayer(Shader &shader, OrthoCamera *camera) {
+  this->shader = shader;
+  this->camera = camera;
+  this->capacity = 0;
+  this->fill = 0;
+
+  glGenVertexArrays(1, &this->vao);
+  glGenBuffers(1, &this->vbo);
+  glGenBuffers(1, &this->ebo);
+  GLState::bind_vertex_array(this->vao);
+  GLState::bind_buffer(GL_ARRAY_BUFFER, this->vbo);
+  GLState::bind_buffer(GL_ELEMENT_ARRAY_BUFFER, this->ebo);
+  sprite_attributes();
+  GLState::bind_vertex_array(0);
+  GLState::bind_buffer(GL_ARRAY_BUFFER, 0);
+  GLState::bind_buffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+SpriteLayer::~SpriteLayer() {
+  GLState::forget_vertex_array(this->vao);
+  GLState::forget_buffer(this->vbo);
+  GLState::forget_buffer(this->ebo);
+  glDeleteVertexArrays(1, &this->vao);
+  glDeleteBuffers(1, &this->vbo);
+  glDeleteBuffers(1, &this->ebo);
+}
+
+void SpriteLayer::rebuild(const std::vector<Sprite> &sprites) {
+  // Sort the sprites by texture, keeping the order they were given in otherwise
+  std::vector<unsigned int> order(sprites.size());
+  for (unsigned int i = 0; i < order.size(); i++) order[i] = i;
+  std::stable_sort(order.begin(), order.end(), [&](unsigned int a, unsigned int b) { return sprites[a].texture.id < sprites[b].texture.id; });
+
+  std::vector<SpriteVertex> vertices(sprites.size() * 4);
+  this->slots.clear();
+  this->textures.assign(sprites.size(), 0);
+  this->fills.assign(sprites.size(), 0);
+  this->fill = 0;
+  this->runs.clear();
+  for (unsigned int slot = 0; slot < order.size(); slot++) {
+    const Sprite &sprite = sprites[order[slot]];
+    sprite_quad(sprite.transform, sprite.texture, sprite.colour, sprite.focus, &vertices[slot * 4]);
+    this->slots[sprite.key] = slot;
+    this->textures[slot] = sprite.texture.id;
+    this->fills[slot] = sprite_fill(sprite.transform, this->camera);
+    this->fill += this->fills[slot];
+
+    if (this->runs.empty() || this->runs.back().texture != sprite.texture.id) this->runs.push_back({ sprite.texture.target, sprite.texture.id, slot, 0 });
+    this->runs.back().count++;
+  }
+
+  GLState::bind_vertex_array(this->vao);
+
+  // Only grow the index buffer when the layer holds more sprites than it ever has
+  if (sprites.size() > this->capacity) {
+    this->capacity = sprites.size();
+    std::vector<unsigned int> indices = sprite_indices(this->capacity);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * indices.size(), indices.data(), GL_STATIC_DRAW);
+  }
+
+  GLState::bind_buffer(GL_ARRAY_BUFFER, this->vbo);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(SpriteVertex) * vertices.size(), vertices.data(), GL_DYNAMIC_DRAW);
+  GLState::bind_buffer(GL_ARRAY_BUFFER, 0);
+  GLState::bind_vertex_array(0);
+}
+
+bool SpriteLayer::update(const Sprite &sprite) {
+  std::map<unsigned long, unsigned int>::iterator slot = this->slots.find(sprite.key);
+  if (slot == this->slots.end() || this->textures[slot->second] != sprite.texture.id) return false;
+
+  SpriteVertex quad[4];
+  sprite_quad(sprite.transform, sprite.texture, sprite.colour, sprite.focus, quad);
+  this->fill -= this->fills[slot->second];
+  this->fills[slot->second] = sprite_fill(sprite.transform, this->camera);
+  this->fill += this->fills[slot->second];
+
+  GLState::bind_buffer(GL_ARRAY_BUFFER, this->vbo);
+  glBufferSubData(GL_ARRAY_BUFFER, sizeof(SpriteVertex) * 4 * slot->second, sizeof(quad), quad);
+  return true;
+}
+
+void SpriteLayer::render() {
+  if (this->runs.empty()) return;
+
+  this->shader.activate();
+  this->shader.set_integer(Uniforms::SPRITE, 0);
+  this->shader.set_integer(Uniforms::FRAMES, 1);
+
+  GLState::bind_vertex_array(this->vao);
+  for (const Run &run : this->runs) {
+    // Regular textures are sampled from the first unit, and array textures from the second
+    GLState::bind_texture(run.target == GL_TEXTURE_2D_ARRAY ? 1 : 0, run.target, run.texture);
+    glDrawElementsBaseVertex(GL_TRIANGLES, run.count * 6, GL_UNSIGNED_INT, 0, run.first * 4);
+    RenderStats::draw_calls++;
+  }
+
+  RenderStats::sprites += this->slots.size();
+  RenderStats::fill += this->fill;
 }
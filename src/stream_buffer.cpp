@@ -0,0 +1,116 @@
+#include "stream_buffer.h"
+
+bool StreamBuffer::persistent = true;
+
+// The buffer, where it is mapped (if it is), the region being filled and the byte the next write starts from
+static unsigned int stream_buffer = 0;
+static char *mapped = nullptr;
+static unsigned int region = 0, head = 0;
+
+// The fence behind each region, and which of the full regions still have to be fenced
+static GLsync fences[StreamBuffer::REGIONS] = {};
+static bool unfenced[StreamBuffer::REGIONS] = {};
+
+// How long to wait for the GPU to finish drawing from a region before giving up on it, in nanoseconds
+static const GLuint64 FENCE_TIMEOUT = 1000000000;
+
+void StreamBuffer::init() {
+  const unsigned int size = StreamBuffer::REGIONS * StreamBuffer::REGION_SIZE;
+  glGenBuffers(1, &stream_buffer);
+  GLState::bind_buffer(GL_ARRAY_BUFFER, stream_buffer);
+  region = head = 0;
+
+  if (StreamBuffer::persistent && !GLAD_GL_ARB_buffer_storage) {
+    printf("[WARNING] ARB_buffer_storage is not supported, streaming vertices by orphaning buffers instead\n");
+    StreamBuffer::persistent = false;
+  }
+
+  if (StreamBuffer::persistent) {
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glBufferStorage(GL_ARRAY_BUFFER, size, nullptr, flags);
+    mapped = (char *)glMapBufferRange(GL_ARRAY_BUFFER, 0, size, flags);
+    if (mapped != nullptr) return;
+
+    // Immutable storage cannot be reallocated, so start over with a new buffer
+    printf("[WARNING] Stream buffer could not be mapped, streaming vertices by orphaning buffers instead\n");
+    StreamBuffer::persistent = false;
+    GLState::forget_buffer(stream_buffer);
+    glDeleteBuffers(1, &stream_buffer);
+    glGenBuffers(1, &stream_buffer);
+    GLState::bind_buffer(GL_ARRAY_BUFFER, stream_buffer);
+  }
+
+  glBufferData(GL_ARRAY_BUFFER, size, nullptr, GL_STREAM_DRAW);
+}
+
+void StreamBuffer::destroy() {
+  for (unsigned int i = 0; i < StreamBuffer::REGIONS; i++) {
+    if (fences[i] != nullptr) glDeleteSync(fences[i]);
+    fences[i] = nullptr;
+    unfenced[i] = false;
+  }
+
+  if (mapped != nullptr) {
+    GLState::bind_buffer(GL_ARRAY_BUFFER, stream_buffer);
+    glUnmapBuffer(GL_ARRAY_BUFFER);
+    mapped = nullptr;
+  }
+
+  GLState::forget_buffer(stream_buffer);
+  glDeleteBuffers(1, &stream_buffer);
+  stream_buffer = 0;
+}
+
+unsigned int StreamBuffer::id() {
+  return stream_buffer;
+}
+
+unsigned int StreamBuffer::write(const void *data, unsigned int size, unsigned int stride) {
+  if (size + stride > StreamBuffer::REGION_SIZE) throw std::runtime_error("[ERROR] Write does not fit into a region of the stream buffer!");
+  std::chrono::high_resolution_clock::time_point start_point = std::chrono::high_resolution_clock::now();
+
+  // The vertices are addressed by their index, so they have to start on a multiple of their stride
+  unsigned int start = ((head + stride - 1) / stride) * stride;
+  GLState::bind_buffer(GL_ARRAY_BUFFER, stream_buffer);
+
+  // Move on to the next region once this one is full
+  if (start + size > (region + 1) * StreamBuffer::REGION_SIZE) {
+    if (mapped != nullptr) unfenced[region] = true;
+
+    region = (region + 1) % StreamBuffer::REGIONS;
+    start = ((region * StreamBuffer::REGION_SIZE + stride - 1) / stride) * stride;
+
+    // A single frame filled the whole ring, so the region has to be fenced right away
+    if (unfenced[region]) {
+      fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+      unfenced[region] = false;
+    }
+
+    // Wait for the GPU to be done with the region before writing over it. With three regions, it has usually long
+    // finished. Without the mapping, hand the driver fresh storage instead, letting it free the old one once it can.
+    if (mapped != nullptr && fences[region] != nullptr) {
+      if (glClientWaitSync(fences[region], GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT) == GL_TIMEOUT_EXPIRED) printf("[WARNING] Timed out waiting for the GPU to release a region of the stream buffer\n");
+      glDeleteSync(fences[region]);
+      fences[region] = nullptr;
+    } else if (mapped == nullptr && region == 0) {
+      glBufferData(GL_ARRAY_BUFFER, StreamBuffer::REGIONS * StreamBuffer::REGION_SIZE, nullptr, GL_STREAM_DRAW);
+    }
+  }
+
+  if (mapped != nullptr) std::memcpy(mapped + start, data, size);
+  else glBufferSubData(GL_ARRAY_BUFFER, start, size, data);
+  head = start + size;
+
+  RenderStats::uploaded += size;
+  RenderStats::upload_time += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start_point).count();
+  return start / stride;
+}
+
+void StreamBuffer::end_frame() {
+  // Fencing flushes the commands issued so far, which the end of a frame does anyway
+  for (unsigned int i = 0; i < StreamBuffer::REGIONS; i++) {
+    if (!unfenced[i]) continue;
+    fences[i] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    unfenced[i] = false;
+  }
+}
@@ -1,17 +1,20 @@
 #include "texture.h"
 
-// This is a different way to set variable defaults
+// This is a different way to set variable defaults.
+// No GL texture is generated until the texture is, so textures can be created and copied around freely, even without a context.
 Texture::Texture() :
+  id(0),
   width(0), 
   height(0), 
+  uv(glm::vec4(0.0f, 0.0f, 1.0f, 1.0f)),
+  target(GL_TEXTURE_2D),
+  layer(0),
   texture_format(GL_RGB), 
   image_format(GL_RGB), 
   wrap_s(GL_CLAMP_TO_EDGE), 
   wrap_t(GL_CLAMP_TO_EDGE), 
   filter_min(GL_LINEAR), 
-  filter_max(GL_LINEAR) {
-    glGenTextures(1, &this->id);
-}
+  filter_max(GL_LINEAR) { }
 
 void Texture::generate(unsigned int width, unsigned int height, unsigned char *data) {
   // Set the texture width and height of the texture
@@ -19,7 +22,8 @@ void Texture::generate(unsigned int width, unsigned int height, unsigned char *d
   this->height = height;
   
   // Actually generate the texture
-  glBindTexture(GL_TEXTURE_2D, this->id);
+  if (this->id == 0) glGenTextures(1, &this->id);
+  GLState::edit_texture(GL_TEXTURE_2D, this->id);
   glTexImage2D(GL_TEXTURE_2D, 0, this->texture_format, width, height, 0, this->image_format, GL_UNSIGNED_BYTE, data);
 
   // Generate mipmaps so the texture looks good after downscaling and upscaling
@@ -30,11 +34,26 @@ void Texture::generate(unsigned int width, unsigned int height, unsigned char *d
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+}
+
+void Texture::generate(unsigned int width, unsigned int height, unsigned int layers, unsigned char *data) {
+  this->width = width;
+  this->height = height;
+  this->target = GL_TEXTURE_2D_ARRAY;
+
+  // Upload every layer at once
+  if (this->id == 0) glGenTextures(1, &this->id);
+  GLState::edit_texture(GL_TEXTURE_2D_ARRAY, this->id);
+  glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, this->texture_format, width, height, layers, 0, this->image_format, GL_UNSIGNED_BYTE, data);
+  glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
 
-  // Unbind the texture
-  glBindTexture(GL_TEXTURE_2D, 0);
+  // Use the same settings as a regular texture
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 }
 
-void Texture::bind() const {
-  glBindTexture(GL_TEXTURE_2D, this->id);
+void Texture::bind(unsigned int unit) const {
+  GLState::bind_texture(unit, this->target, this->id);
 }
@@ -1,9 +1,10 @@
 #include "utils.h"
 #include "object.h"
 
-double Time::delta = 0.0f;
+double Time::accumulator = 0.0f;
 
 glm::vec2 WindowSize = glm::vec2(0.0f);
+glm::vec2 WorldSize = glm::vec2(0.0f);
 
 glm::vec2 screen_to_world(glm::vec2 screen_point) {
   // printf("windowsize: %.2f, %.2f\n", WindowSize.x, WindowSize.y);